@@ -0,0 +1,117 @@
+#!/usr/bin/env bash
+#
+# adaptive-enroll-sweep.sh — Presses saved vs FRR/FAR for adaptive enrollment (P20, doc 20 §21)
+#
+# For each stop rule N (stop after N consecutive presses that add no
+# coverage) runs sigfm-batch --adaptive-enroll=N on every finger of the
+# enroll corpus, in capture order, verifying against the same finger
+# (genuine) and every other finger (impostor) of the verify corpus.
+# "fixed" is today's enrollment: the first ENROLL_MAX presses.  Prints the
+# presses each finger needed and the aggregate FRR and FAR.
+#
+# Usage:
+#   ./tools/benchmark/adaptive-enroll-sweep.sh <s1_corpus> <s2_corpus> [N...]
+#
+# Environment:
+#   ENROLL_MIN=8  ENROLL_MAX=20  NOVELTY=<score threshold>
+#
+# Examples:
+#   ./tools/benchmark/adaptive-enroll-sweep.sh corpus/5finger corpus/5finger-s2
+#   ENROLL_MIN=10 ./tools/benchmark/adaptive-enroll-sweep.sh corpus/5finger corpus/5finger-s2 2 3 4
+#
+# SPDX-License-Identifier: LGPL-2.1-or-later
+
+set -euo pipefail
+
+S1_DIR="${1:?Usage: $0 <s1_corpus> <s2_corpus> [N...]}"
+S2_DIR="${2:?Usage: $0 <s1_corpus> <s2_corpus> [N...]}"
+shift 2
+RULES=("$@")
+[[ ${#RULES[@]} -eq 0 ]] && RULES=(2 3 4 5)
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+BATCH="$SCRIPT_DIR/sigfm-batch"
+ST=7        # Phase 12 operating point (doc 20 §1)
+ENROLL_MIN="${ENROLL_MIN:-8}"
+ENROLL_MAX="${ENROLL_MAX:-20}"   # nr_enroll_stages
+NOVELTY="${NOVELTY:-$ST}"
+
+if [[ ! -x "$BATCH" ]]; then
+    echo "sigfm-batch not found — run: make -C tools" >&2
+    exit 1
+fi
+
+FINGERS=()
+for d in "$S1_DIR"/*/; do
+    [[ -d "$d" && -d "$S2_DIR/$(basename "$d")" ]] && FINGERS+=("$(basename "$d")")
+done
+if [[ ${#FINGERS[@]} -eq 0 ]]; then
+    echo "ERROR: no finger subdirectories common to $S1_DIR and $S2_DIR" >&2
+    exit 1
+fi
+
+echo "══════════════════════════════════════════════════════════════"
+echo "  Adaptive Enrollment Sweep"
+echo "══════════════════════════════════════════════════════════════"
+echo "  S1 (enroll):  $S1_DIR"
+echo "  S2 (verify):  $S2_DIR"
+echo "  Fingers:      ${FINGERS[*]}"
+echo "  Threshold:    $ST  (novelty: $NOVELTY)"
+echo "  Bounds:       [$ENROLL_MIN, $ENROLL_MAX] presses"
+echo "──────────────────────────────────────────────────────────────"
+
+# Prints: MATCHES REJECTIONS PRESSES
+run_batch() {
+    local output
+    output=$("$BATCH" "$@" --score-threshold=$ST 2>&1) || true
+    local m f p
+    m=$(grep -oP 'Matches:\s+\K\d+' <<< "$output" || echo 0)
+    f=$(grep -oP 'Rejections:\s+\K\d+' <<< "$output" || echo 0)
+    p=$(grep -oP 'Adaptive: \K\d+' <<< "$output" || echo 0)
+    echo "$m $f $p"
+}
+
+header="  $(printf '%-7s' rule)"
+for finger in "${FINGERS[@]}"; do header+="$(printf '  %8s' "$finger")"; done
+header+="$(printf '  %7s  %7s  %7s' mean FRR FAR)"
+echo "$header"
+
+for rule in fixed "${RULES[@]}"; do
+    g_m=0; g_f=0; i_m=0; i_f=0; total_p=0
+    row="  $(printf '%-7s' "$rule")"
+
+    for finger in "${FINGERS[@]}"; do
+        mapfile -t enroll_args < <(ls "$S1_DIR/$finger"/capture_*.pgm | sort)
+        mapfile -t verify_args < <(ls "$S2_DIR/$finger"/capture_*.pgm | sort)
+        if [[ "$rule" == fixed ]]; then
+            enroll_args=("${enroll_args[@]:0:$ENROLL_MAX}")
+            opts=()
+        else
+            opts=(--adaptive-enroll="$rule" --enroll-min="$ENROLL_MIN"
+                  --max-subtemplates="$ENROLL_MAX" --novelty-score="$NOVELTY")
+        fi
+
+        read -r m f p < <(run_batch --enroll "${enroll_args[@]}" \
+            --verify "${verify_args[@]}" "${opts[@]}")
+        [[ "$rule" == fixed ]] && p=${#enroll_args[@]}
+        g_m=$((g_m + m)); g_f=$((g_f + f)); total_p=$((total_p + p))
+        row+="$(printf '  %8s' "$p")"
+
+        for other in "${FINGERS[@]}"; do
+            [[ "$other" == "$finger" ]] && continue
+            mapfile -t imp_args < <(ls "$S2_DIR/$other"/capture_*.pgm | sort)
+            read -r m f p < <(run_batch --enroll "${enroll_args[@]}" \
+                --verify "${imp_args[@]}" "${opts[@]}")
+            i_m=$((i_m + m)); i_f=$((i_f + f))
+        done
+    done
+
+    mean=$(awk "BEGIN{printf \"%.1f\", $total_p/${#FINGERS[@]}}")
+    frr=$(awk "BEGIN{t=$g_m+$g_f; printf \"%.1f\", t ? $g_f/t*100 : 0}")
+    far=$(awk "BEGIN{t=$i_m+$i_f; printf \"%.2f\", t ? $i_m/t*100 : 0}")
+    row+="$(printf '  %7s  %6s%%  %6s%%' "$mean" "$frr" "$far")"
+    echo "$row"
+done
+
+echo "══════════════════════════════════════════════════════════════"
+echo "  Columns per finger: presses until enrollment ended"
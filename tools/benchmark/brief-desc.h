@@ -0,0 +1,179 @@
+/*
+ * brief-desc.h — BRIEF-256 descriptor helpers for the offline benchmarks
+ *
+ * Shared by the descriptor-level tools (vocab-train, ...).  Descriptors are
+ * the 32-byte unsteered BRIEF-256 strings produced by sigfm.c; they can be
+ * loaded from FP_SAVE_RAW dumps (desc_NNNN.bin: N × 32 bytes, keypoint
+ * order) or generated by a synthetic finger model when no corpus dump is at
+ * hand.
+ *
+ * Header-only: every function is static inline so each tool stays a single
+ * translation unit (see Makefile).
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef BRIEF_DESC_H
+#define BRIEF_DESC_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Matches sigfm.c: MAX_KP keypoints, 256-bit descriptors */
+#define BRIEF_BYTES     32
+#define BRIEF_WORDS     4
+#define BRIEF_MAX_KP    128
+
+typedef struct {
+    uint64_t w[BRIEF_WORDS];
+} BriefDesc;
+
+/* One frame's worth of descriptors */
+typedef struct {
+    BriefDesc d[BRIEF_MAX_KP];
+    int       n;
+} BriefSet;
+
+static inline int
+brief_hamming(const BriefDesc *a, const BriefDesc *b)
+{
+    return __builtin_popcountll(a->w[0] ^ b->w[0]) +
+           __builtin_popcountll(a->w[1] ^ b->w[1]) +
+           __builtin_popcountll(a->w[2] ^ b->w[2]) +
+           __builtin_popcountll(a->w[3] ^ b->w[3]);
+}
+
+static inline int
+brief_bit(const BriefDesc *d, int bit)
+{
+    return (int)((d->w[bit >> 6] >> (bit & 63)) & 1);
+}
+
+/* ------------------------------------------------------------------ */
+/* Timing                                                              */
+/* ------------------------------------------------------------------ */
+
+static inline double
+brief_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/* ------------------------------------------------------------------ */
+/* Deterministic RNG (xorshift64*) — reproducible synthetic corpora    */
+/* ------------------------------------------------------------------ */
+
+static inline uint64_t
+brief_rng_next(uint64_t *s)
+{
+    uint64_t x = *s;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *s = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static inline double
+brief_rng_unit(uint64_t *s)
+{
+    return (double)(brief_rng_next(s) >> 11) / 9007199254740992.0;
+}
+
+static inline void
+brief_random(BriefDesc *d, uint64_t *rng)
+{
+    for (int i = 0; i < BRIEF_WORDS; i++)
+        d->w[i] = brief_rng_next(rng);
+}
+
+/* Flip each bit independently with probability p */
+static inline void
+brief_perturb(BriefDesc *d, double p, uint64_t *rng)
+{
+    for (int bit = 0; bit < BRIEF_BYTES * 8; bit++)
+        if (brief_rng_unit(rng) < p)
+            d->w[bit >> 6] ^= 1ULL << (bit & 63);
+}
+
+/* ------------------------------------------------------------------ */
+/* Synthetic finger model                                              */
+/* ------------------------------------------------------------------ */
+
+/* A finger is a strip of SYNTH_POOL ridge features.  Each feature is a
+ * perturbed copy of one of SYNTH_PROTOTYPES shared local ridge patterns,
+ * because fingers of one hand share ridge spacing and texture at 508 DPI
+ * (BENCHMARKS.md, "Fundamental Constraints") and descriptors therefore
+ * cluster instead of being uniform in Hamming space.  A capture sees a
+ * window of BRIEF_MAX_KP consecutive features at a random offset
+ * (placement shift), each re-described with bit-flip noise, plus a share
+ * of spurious corners.  Two presses of one feature land at Hamming ~75,
+ * different features of one prototype at ~100, unrelated descriptors at
+ * ~128 ± 8.  The parameters are illustrative, not fitted: use them for
+ * latency scaling, and real desc_*.bin dumps for accuracy numbers. */
+#define SYNTH_PROTOTYPES    512
+#define SYNTH_PROTO_FLIP_P  0.15
+#define SYNTH_POOL          320
+#define SYNTH_FLIP_P        0.18
+#define SYNTH_SPURIOUS_P    0.25
+
+typedef struct {
+    BriefDesc pool[SYNTH_POOL];
+} SynthFinger;
+
+static inline void
+synth_finger_init(SynthFinger *f, uint64_t seed)
+{
+    uint64_t rng = seed * 0x9E3779B97F4A7C15ULL + 1;
+    for (int i = 0; i < SYNTH_POOL; i++) {
+        /* Prototype j is the same for every finger: seeded by j alone */
+        uint64_t j = brief_rng_next(&rng) % SYNTH_PROTOTYPES;
+        uint64_t prng = 0x0DDBA11ULL + j * 0x9E3779B97F4A7C15ULL;
+        brief_random(&f->pool[i], &prng);
+        brief_perturb(&f->pool[i], SYNTH_PROTO_FLIP_P, &rng);
+    }
+}
+
+static inline void
+synth_capture(const SynthFinger *f, BriefSet *out, uint64_t *rng)
+{
+    int off = (int)(brief_rng_next(rng) % (SYNTH_POOL - BRIEF_MAX_KP + 1));
+    out->n = BRIEF_MAX_KP;
+    for (int i = 0; i < BRIEF_MAX_KP; i++) {
+        if (brief_rng_unit(rng) < SYNTH_SPURIOUS_P) {
+            brief_random(&out->d[i], rng);
+        } else {
+            out->d[i] = f->pool[off + i];
+            brief_perturb(&out->d[i], SYNTH_FLIP_P, rng);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Dump I/O                                                            */
+/* ------------------------------------------------------------------ */
+
+/* Read a desc_NNNN.bin dump (raw 32-byte records).  Returns descriptor
+ * count, or -1 on error.  Records beyond BRIEF_MAX_KP are ignored. */
+static inline int
+brief_set_read(const char *path, BriefSet *out)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return -1; }
+
+    out->n = 0;
+    unsigned char rec[BRIEF_BYTES];
+    while (out->n < BRIEF_MAX_KP && fread(rec, 1, BRIEF_BYTES, f) == BRIEF_BYTES) {
+        memcpy(out->d[out->n].w, rec, BRIEF_BYTES);
+        out->n++;
+    }
+    fclose(f);
+    return out->n;
+}
+
+#endif /* BRIEF_DESC_H */
@@ -0,0 +1,215 @@
+/*
+ * brief-mih.h — Multi-index hashing over BRIEF-256 (P3, doc 20 §4)
+ *
+ * Splits each 256-bit descriptor into m = 256 / sub_bits disjoint substrings
+ * and keeps one dense hash table per substring (CSR layout: bucket offsets +
+ * descriptor ids).  By the pigeonhole principle, any descriptor within
+ * Hamming distance r of the query differs by at most ⌊r/m⌋ bits in at least
+ * one substring, so probing every table with all keys within ⌊r/m⌋ of the
+ * query's substring retrieves the exact r-neighbourhood.
+ *
+ * The index is read-only after build; per-query state lives in a
+ * caller-owned BriefMihScratch, so concurrent queries need only one scratch
+ * per thread.
+ *
+ * Header-only, plain C99 + GCC builtins, same as brief-desc.h.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef BRIEF_MIH_H
+#define BRIEF_MIH_H
+
+#include "brief-desc.h"
+
+#define BRIEF_MIH_MAX_TABLES  32
+
+typedef struct {
+    int              sub_bits;      /* 8 or 16 */
+    int              m;             /* number of substrings/tables */
+    int              n;             /* indexed descriptors */
+    const BriefDesc *db;            /* not owned */
+    uint32_t        *offsets[BRIEF_MIH_MAX_TABLES];  /* 2^sub_bits + 1 each */
+    uint32_t        *ids[BRIEF_MIH_MAX_TABLES];      /* n each */
+} BriefMih;
+
+typedef struct {
+    uint32_t *stamp;                /* per-descriptor "seen in query #epoch" */
+    uint32_t  epoch;
+    long      candidates;           /* full distances computed (statistics) */
+} BriefMihScratch;
+
+static inline uint32_t
+brief_mih_substring(const BriefDesc *d, int sub_bits, int t)
+{
+    int bit = t * sub_bits;
+    return (uint32_t)(d->w[bit >> 6] >> (bit & 63)) & ((1u << sub_bits) - 1);
+}
+
+static inline void
+brief_mih_free(BriefMih *mih)
+{
+    for (int t = 0; t < mih->m; t++) {
+        free(mih->offsets[t]);
+        free(mih->ids[t]);
+    }
+    memset(mih, 0, sizeof(*mih));
+}
+
+/* Counting-sort build: O(m · (n + 2^sub_bits)).  Returns 0 or -1. */
+static inline int
+brief_mih_build(BriefMih *mih, const BriefDesc *db, int n, int sub_bits)
+{
+    memset(mih, 0, sizeof(*mih));
+    if (sub_bits != 8 && sub_bits != 16) return -1;
+
+    mih->sub_bits = sub_bits;
+    mih->m = (BRIEF_BYTES * 8) / sub_bits;
+    mih->n = n;
+    mih->db = db;
+
+    size_t buckets = (size_t)1 << sub_bits;
+    for (int t = 0; t < mih->m; t++) {
+        mih->offsets[t] = calloc(buckets + 1, sizeof(uint32_t));
+        mih->ids[t] = malloc((size_t)(n > 0 ? n : 1) * sizeof(uint32_t));
+        if (!mih->offsets[t] || !mih->ids[t]) {
+            brief_mih_free(mih);
+            return -1;
+        }
+
+        uint32_t *off = mih->offsets[t];
+        for (int i = 0; i < n; i++)
+            off[brief_mih_substring(&db[i], sub_bits, t) + 1]++;
+        for (size_t b = 0; b < buckets; b++)
+            off[b + 1] += off[b];
+
+        /* Fill using a moving cursor per bucket, then restore offsets */
+        for (int i = 0; i < n; i++) {
+            uint32_t key = brief_mih_substring(&db[i], sub_bits, t);
+            mih->ids[t][off[key]++] = (uint32_t)i;
+        }
+        for (size_t b = buckets; b > 0; b--)
+            off[b] = off[b - 1];
+        off[0] = 0;
+    }
+    return 0;
+}
+
+static inline int
+brief_mih_scratch_init(BriefMihScratch *s, int n)
+{
+    s->stamp = calloc((size_t)(n > 0 ? n : 1), sizeof(uint32_t));
+    s->epoch = 0;
+    s->candidates = 0;
+    return s->stamp ? 0 : -1;
+}
+
+static inline void
+brief_mih_scratch_free(BriefMihScratch *s)
+{
+    free(s->stamp);
+    s->stamp = NULL;
+}
+
+static inline void
+brief_mih_next_epoch(BriefMihScratch *s, int n)
+{
+    if (++s->epoch == 0) {
+        memset(s->stamp, 0, (size_t)n * sizeof(uint32_t));
+        s->epoch = 1;
+    }
+}
+
+/* Visit every bucket key within substring radius `s` of `key`, i.e. all
+ * masks of popcount s (Gosper's hack), and run BODY for each bucket entry
+ * with its descriptor id bound to ID.  `continue` inside BODY skips to the
+ * next entry. */
+#define BRIEF_MIH_FOREACH_RADIUS(mih, t, key, s, ID, BODY)                    \
+    do {                                                                      \
+        uint32_t _lim = 1u << (mih)->sub_bits;                                \
+        uint32_t _mask = (s) == 0 ? 0 : (1u << (s)) - 1;                      \
+        while (_mask < _lim) {                                                \
+            uint32_t _k = (key) ^ _mask;                                      \
+            const uint32_t *_off = (mih)->offsets[t];                         \
+            for (uint32_t _p = _off[_k]; _p < _off[_k + 1]; _p++) {           \
+                uint32_t ID = (mih)->ids[t][_p];                              \
+                BODY                                                          \
+            }                                                                 \
+            if (_mask == 0) break;                                            \
+            uint32_t _c = _mask & -_mask, _r = _mask + _c;                    \
+            _mask = (((_r ^ _mask) >> 2) / _c) | _r;                          \
+        }                                                                     \
+    } while (0)
+
+/* Exact r-neighbour query.  Writes up to max_out ids with distance ≤ r to
+ * out (unordered) and returns the total count found. */
+static inline int
+brief_mih_radius(const BriefMih *mih, BriefMihScratch *sc, const BriefDesc *q,
+                 int r, int *out, int max_out)
+{
+    int found = 0;
+    int s_max = r / mih->m;
+    if (s_max > mih->sub_bits) s_max = mih->sub_bits;
+
+    brief_mih_next_epoch(sc, mih->n);
+    for (int t = 0; t < mih->m; t++) {
+        uint32_t key = brief_mih_substring(q, mih->sub_bits, t);
+        for (int s = 0; s <= s_max; s++) {
+            BRIEF_MIH_FOREACH_RADIUS(mih, t, key, s, id, {
+                if (sc->stamp[id] == sc->epoch) continue;
+                sc->stamp[id] = sc->epoch;
+                sc->candidates++;
+                if (brief_hamming(q, &mih->db[id]) <= r) {
+                    if (found < max_out) out[found] = (int)id;
+                    found++;
+                }
+            });
+        }
+    }
+    return found;
+}
+
+/* Exact 2-NN by incremental radius search.  After all tables have been
+ * probed up to substring radius s, every descriptor with full distance
+ * ≤ m·(s+1) − 1 has been seen, so the search stops as soon as the current
+ * second-best is within that bound (or `max_dist` is exceeded, in which
+ * case neighbours farther than max_dist are reported as missing: id −1).
+ * Returns the same neighbours as a brute-force scan with ties broken by
+ * lowest id. */
+static inline void
+brief_mih_knn2(const BriefMih *mih, BriefMihScratch *sc, const BriefDesc *q,
+               int max_dist, int *i1, int *d1, int *i2, int *d2)
+{
+    int b1 = -1, b2 = -1, bd1 = max_dist + 1, bd2 = max_dist + 1;
+    uint32_t keys[BRIEF_MIH_MAX_TABLES];
+
+    brief_mih_next_epoch(sc, mih->n);
+    for (int t = 0; t < mih->m; t++)
+        keys[t] = brief_mih_substring(q, mih->sub_bits, t);
+
+    for (int s = 0; s <= mih->sub_bits; s++) {
+        for (int t = 0; t < mih->m; t++) {
+            BRIEF_MIH_FOREACH_RADIUS(mih, t, keys[t], s, id, {
+                if (sc->stamp[id] == sc->epoch) continue;
+                sc->stamp[id] = sc->epoch;
+                sc->candidates++;
+                int d = brief_hamming(q, &mih->db[id]);
+                if (d < bd1 || (d == bd1 && (int)id < b1)) {
+                    b2 = b1; bd2 = bd1;
+                    b1 = (int)id; bd1 = d;
+                } else if (d < bd2 || (d == bd2 && (int)id < b2)) {
+                    b2 = (int)id; bd2 = d;
+                }
+            });
+        }
+        int covered = mih->m * (s + 1) - 1;
+        if (bd2 <= covered || covered >= max_dist) break;
+    }
+
+    *i1 = bd1 <= max_dist ? b1 : -1;
+    *d1 = bd1;
+    *i2 = bd2 <= max_dist ? b2 : -1;
+    *d2 = bd2;
+}
+
+#endif /* BRIEF_MIH_H */
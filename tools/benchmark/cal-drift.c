@@ -0,0 +1,373 @@
+/*
+ * cal-drift.c — Cached air-scan calibration: drift metric vs image error (P10, doc 20 §11)
+ *
+ * The driver captures a fresh background (air-scan) frame on every press.
+ * P10 caches it per session and re-captures only when the guard-column
+ * drift metric (goodix_cal_guard_drift()) moves by more than a bound, or
+ * the cached frame is older than a maximum age.  This tool picks the bound:
+ * it replays a capture taken with the cache disabled, where every press
+ * saved its own air scan, and for each bound simulates the cache and
+ * measures how far the preprocessed output drifts from the fresh-calibration
+ * output.
+ *
+ * Input directory (FP_SAVE_RAW with GOODIX_CAL_CACHE=0, see doc 20 §11.3):
+ *   raw_NNNN.bin   calibration-subtracted frame (uint16 LE, 88×80)
+ *   cal_NNNN.bin   the air scan captured for that press
+ *
+ * Usage:
+ *   cal-drift [--bounds=B1,B2,...] [--max-age=N] [--guard=X0] [-v] DIR
+ *   cal-drift --synthetic[=N] [--bounds=...] [--max-age=N] [-v]
+ *
+ * Build:  see Makefile
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <dirent.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "goodix-preprocess.h"
+
+/* ================================================================== */
+/* Parameters (matching goodix5xx driver defaults)                     */
+/* ================================================================== */
+
+#define SCAN_WIDTH          88
+#define OUT_WIDTH           64
+#define HEIGHT              80
+#define BOOST               4
+#define FRAME_PX            (SCAN_WIDTH * HEIGHT)
+
+#define MAX_PRESSES         4096
+#define MAX_BOUNDS          16
+#define DEFAULT_SYNTHETIC   60
+#define DEFAULT_MAX_AGE     0       /* presses; 0 = no age limit */
+#define CHANGED_LEVELS      8       /* |Δ| above this counts as a changed pixel */
+
+static const int default_bounds[] = { 25, 50, 100, 200, 400, 1 << 20 };
+
+typedef struct {
+    char      name[64];
+    uint16_t *raw;          /* before calibration subtract */
+    uint16_t *cal;
+    uint8_t  *fresh;        /* output with this press's own air scan */
+} Press;
+
+/* ================================================================== */
+/* Input                                                               */
+/* ================================================================== */
+
+static uint16_t *
+read_raw(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    uint16_t *buf = malloc(FRAME_PX * sizeof(uint16_t));
+    size_t got = buf ? fread(buf, sizeof(uint16_t), FRAME_PX, f) : 0;
+    fclose(f);
+    if (got != FRAME_PX) {
+        fprintf(stderr, "%s: short read\n", path);
+        free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+static int
+cmp_name(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* raw_NNNN.bin holds (uint16)(0xffff − cal + raw) — linear_subtract_inplace()
+ * is invertible, so the pre-subtract frame is post + cal + 1 mod 2^16. */
+static int
+load_dir(const char *dir, Press *presses)
+{
+    DIR *d = opendir(dir);
+    if (!d) { perror(dir); return -1; }
+
+    char *names[MAX_PRESSES];
+    int n_names = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL && n_names < MAX_PRESSES) {
+        size_t len = strlen(ent->d_name);
+        if (strncmp(ent->d_name, "raw_", 4) == 0 && len > 8 && len < 60 &&
+            strcmp(ent->d_name + len - 4, ".bin") == 0)
+            names[n_names++] = strdup(ent->d_name);
+    }
+    closedir(d);
+    qsort(names, (size_t)n_names, sizeof(names[0]), cmp_name);
+
+    int n = 0;
+    for (int i = 0; i < n_names; i++) {
+        char raw_path[1024], cal_path[1024];
+        snprintf(raw_path, sizeof(raw_path), "%s/%s", dir, names[i]);
+        snprintf(cal_path, sizeof(cal_path), "%s/cal_%s", dir, names[i] + 4);
+
+        Press *p = &presses[n];
+        p->cal = read_raw(cal_path);
+        if (!p->cal) {
+            fprintf(stderr, "  %s: no cal_%s, skipped\n", names[i], names[i] + 4);
+            free(names[i]);
+            continue;
+        }
+        p->raw = read_raw(raw_path);
+        if (!p->raw) { free(p->cal); free(names[i]); continue; }
+        for (int k = 0; k < FRAME_PX; k++)
+            p->raw[k] = (uint16_t)(p->raw[k] + p->cal[k] + 1);
+        snprintf(p->name, sizeof(p->name), "%s", names[i]);
+        free(names[i]);
+        n++;
+    }
+    return n;
+}
+
+/* ================================================================== */
+/* Synthetic session                                                   */
+/* ================================================================== */
+
+static uint32_t
+xorshift32(uint32_t *s)
+{
+    *s ^= *s << 13; *s ^= *s >> 17; *s ^= *s << 5;
+    return *s;
+}
+
+/* Fixed-pattern background that warms up over the session: a global offset
+ * that rises and wobbles plus a slowly growing left-right gradient, with
+ * per-frame read noise.  Halfway through, the fixed pattern itself changes
+ * (as after a sensor reset), which a uniform-offset metric would miss.
+ * The finger (ridges at ~9 px period) covers the retained columns and only
+ * its edge reaches the guard columns. */
+static int
+make_synthetic(int n, Press *presses)
+{
+    uint32_t rng = 0x2545f491u;
+    static int16_t fpn[FRAME_PX];
+    for (int k = 0; k < FRAME_PX; k++)
+        fpn[k] = (int16_t)((int)(xorshift32(&rng) % 801) - 400 + ((k / SCAN_WIDTH) % 4) * 60);
+
+    for (int i = 0; i < n; i++) {
+        if (i == n / 2)
+            for (int k = 0; k < FRAME_PX; k++)
+                fpn[k] = (int16_t)(fpn[k] + (int)(xorshift32(&rng) % 301) - 150);
+
+        Press *p = &presses[i];
+        snprintf(p->name, sizeof(p->name), "synthetic_%04d", i);
+        p->raw = malloc(FRAME_PX * sizeof(uint16_t));
+        p->cal = malloc(FRAME_PX * sizeof(uint16_t));
+        if (!p->raw || !p->cal) { perror("malloc"); return -1; }
+
+        double offset = 8.0 * i + 60.0 * sin(i / 5.0);
+        double slope = 0.05 * i;
+        double angle = 0.3 * (i % 7);
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < SCAN_WIDTH; x++) {
+                int k = y * SCAN_WIDTH + x;
+                double bg = 0x9000 + fpn[k] + offset + slope * x;
+                p->cal[k] = (uint16_t)(bg + (int)(xorshift32(&rng) % 31) - 15);
+
+                double cover = x < 60 ? 1.0 : x < 70 ? (70 - x) / 10.0 : 0.0;
+                double ridge = 0.5 + 0.5 * sin((x * cos(angle) + y * sin(angle)) * 0.7);
+                double finger = cover * (1200.0 + 1500.0 * ridge);
+                p->raw[k] = (uint16_t)(bg - finger + (int)(xorshift32(&rng) % 31) - 15);
+            }
+        }
+    }
+    return n;
+}
+
+/* ================================================================== */
+/* Simulation                                                          */
+/* ================================================================== */
+
+static void
+process(const uint16_t *raw, const uint16_t *cal, uint8_t *out)
+{
+    uint16_t work[FRAME_PX];
+    memcpy(work, raw, sizeof(work));
+    goodix_preprocess_frame(work, cal, SCAN_WIDTH, HEIGHT, OUT_WIDTH, BOOST, out);
+}
+
+/* Mean |Δ| and fraction of pixels with |Δ| > CHANGED_LEVELS */
+static void
+output_error(const uint8_t *a, const uint8_t *b, double *mean_abs, double *changed)
+{
+    long sum = 0, n_changed = 0;
+    for (int k = 0; k < OUT_WIDTH * HEIGHT; k++) {
+        int d = abs((int)a[k] - (int)b[k]);
+        sum += d;
+        if (d > CHANGED_LEVELS) n_changed++;
+    }
+    *mean_abs = (double)sum / (OUT_WIDTH * HEIGHT);
+    *changed = (double)n_changed / (OUT_WIDTH * HEIGHT);
+}
+
+typedef struct {
+    int    captures;
+    int    hits;
+    double err_sum, err_max;        /* mean |Δ| per hit */
+    double chg_sum, chg_max;        /* changed-pixel fraction per hit */
+} SimResult;
+
+/* One session with the cache.  A drift beyond the bound only marks the
+ * cache stale: the press in hand is already processed with the cached
+ * frame, the next press re-captures. */
+static void
+simulate(Press *presses, int n, int bound, int max_age, int guard_x0,
+         int verbose, SimResult *r)
+{
+    uint8_t out[OUT_WIDTH * HEIGHT];
+    int cached = -1, ref = 0, stale = 1;
+
+    memset(r, 0, sizeof(*r));
+    for (int i = 0; i < n; i++) {
+        Press *p = &presses[i];
+        if (stale || (max_age > 0 && i - cached >= max_age)) {
+            cached = i;
+            ref = goodix_cal_guard_drift(p->raw, p->cal, SCAN_WIDTH, HEIGHT, guard_x0);
+            stale = 0;
+            r->captures++;
+            if (verbose)
+                printf("    %-20s capture   ref %6d\n", p->name, ref);
+            continue;
+        }
+
+        const uint16_t *cal = presses[cached].cal;
+        int drift = goodix_cal_guard_drift(p->raw, cal, SCAN_WIDTH, HEIGHT, guard_x0) - ref;
+        if (drift > bound)
+            stale = 1;
+
+        double err, chg;
+        process(p->raw, cal, out);
+        output_error(out, p->fresh, &err, &chg);
+        r->hits++;
+        r->err_sum += err;
+        r->chg_sum += chg;
+        if (err > r->err_max) r->err_max = err;
+        if (chg > r->chg_max) r->chg_max = chg;
+
+        if (verbose)
+            printf("    %-20s cached    drift %6d  |Δ| %5.2f  changed %5.1f%%%s\n",
+                   p->name, drift, err, chg * 100, stale ? "  → stale" : "");
+    }
+}
+
+/* ================================================================== */
+/* Usage                                                               */
+/* ================================================================== */
+
+static void
+usage(const char *argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [--bounds=B1,B2,...] [--max-age=N] [--guard=X0] [-v] DIR\n"
+        "       %s --synthetic[=N] [--bounds=...] [--max-age=N] [-v]\n"
+        "\n"
+        "  DIR            raw_NNNN.bin + cal_NNNN.bin per press (cache disabled)\n"
+        "  --synthetic=N  generated session with a warming background (default: %d)\n"
+        "  --bounds=...   drift bounds to simulate, raw ADC units\n"
+        "  --max-age=N    re-capture after N presses regardless (default: none)\n"
+        "  --guard=X0     first guard column (default: %d)\n"
+        "  -v             per-press trace for every bound\n",
+        argv0, argv0, DEFAULT_SYNTHETIC, OUT_WIDTH);
+    exit(1);
+}
+
+/* ================================================================== */
+/* Main                                                                */
+/* ================================================================== */
+
+int
+main(int argc, char *argv[])
+{
+    static Press presses[MAX_PRESSES];
+    const char *dir = NULL;
+    int synthetic = 0;
+    int max_age = DEFAULT_MAX_AGE;
+    int guard_x0 = OUT_WIDTH;
+    int verbose = 0;
+    int bounds[MAX_BOUNDS], n_bounds = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--bounds=", 9) == 0) {
+            char *s = argv[i] + 9;
+            while (*s && n_bounds < MAX_BOUNDS) {
+                bounds[n_bounds++] = (int)strtol(s, &s, 10);
+                if (*s == ',') s++;
+                else if (*s) usage(argv[0]);
+            }
+        } else if (strcmp(argv[i], "--synthetic") == 0)
+            synthetic = DEFAULT_SYNTHETIC;
+        else if (strncmp(argv[i], "--synthetic=", 12) == 0)
+            synthetic = atoi(argv[i] + 12);
+        else if (strncmp(argv[i], "--max-age=", 10) == 0)
+            max_age = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "--guard=", 8) == 0)
+            guard_x0 = atoi(argv[i] + 8);
+        else if (strcmp(argv[i], "-v") == 0)
+            verbose = 1;
+        else if (argv[i][0] == '-')
+            usage(argv[0]);
+        else
+            dir = argv[i];
+    }
+    if ((!dir && synthetic <= 0) || synthetic > MAX_PRESSES ||
+        guard_x0 < 1 || guard_x0 >= SCAN_WIDTH)
+        usage(argv[0]);
+    if (n_bounds == 0) {
+        n_bounds = (int)(sizeof(default_bounds) / sizeof(default_bounds[0]));
+        memcpy(bounds, default_bounds, sizeof(default_bounds));
+    }
+
+    int n = synthetic > 0 ? make_synthetic(synthetic, presses) : load_dir(dir, presses);
+    if (n < 2) {
+        fprintf(stderr, "Need at least 2 presses with their air scans\n");
+        return 1;
+    }
+    for (int i = 0; i < n; i++) {
+        presses[i].fresh = malloc(OUT_WIDTH * HEIGHT);
+        if (!presses[i].fresh) { perror("malloc"); return 1; }
+        process(presses[i].raw, presses[i].cal, presses[i].fresh);
+    }
+
+    char age[32];
+    if (max_age > 0)
+        snprintf(age, sizeof(age), "%d presses", max_age);
+    else
+        snprintf(age, sizeof(age), "none");
+    printf("cal-drift: %d presses from %s, guard columns %d–%d, max age %s\n",
+           n, synthetic > 0 ? "synthetic session" : dir, guard_x0, SCAN_WIDTH - 1, age);
+    printf("\n  %-9s  %8s  %8s  %10s  %10s  %12s  %12s\n",
+           "bound", "captures", "hit rate", "mean |Δ|", "max |Δ|",
+           "mean chg %", "max chg %");
+
+    for (int b = 0; b < n_bounds; b++) {
+        SimResult r;
+        if (verbose)
+            printf("  bound %d:\n", bounds[b]);
+        simulate(presses, n, bounds[b], max_age, guard_x0, verbose, &r);
+
+        char label[16];
+        if (bounds[b] >= 1 << 20)
+            snprintf(label, sizeof(label), "never");
+        else
+            snprintf(label, sizeof(label), "%d", bounds[b]);
+        printf("  %-9s  %8d  %7.1f%%  %10.2f  %10.2f  %11.1f%%  %11.1f%%\n",
+               label, r.captures, 100.0 * r.hits / n,
+               r.hits ? r.err_sum / r.hits : 0.0, r.err_max,
+               r.hits ? 100.0 * r.chg_sum / r.hits : 0.0, 100.0 * r.chg_max);
+    }
+
+    for (int i = 0; i < n; i++) {
+        free(presses[i].raw);
+        free(presses[i].cal);
+        free(presses[i].fresh);
+    }
+    return 0;
+}
@@ -0,0 +1,390 @@
+/*
+ * cancel-bench.c — Cancel latency and polling cost of bounded matching (P24, doc 20 §25)
+ *
+ * Runs a stand-in for the driver's verify — the sub-template loop over
+ * sigfm_match_score()'s two stages, brute-force 2-NN with the ratio test
+ * and RANSAC over a rigid transform — on synthetic fingers that carry
+ * keypoint positions, with sigfm-cancel.h polls at the three levels the
+ * fork would get them: every KNN row, every RANSAC iteration, every
+ * sub-template.  It reports:
+ *
+ *   cost       verify time with no token, a token, and a token with an
+ *              armed deadline, per poll stride; scores must be identical
+ *   deadline   how far past an expired deadline a verify still runs, and
+ *              how often the best-so-far score is already an accept
+ *   cancel     request → return latency with sigfm_cancel_request() called
+ *              from a second thread, as the GCancellable handler would
+ *
+ * The stand-in keeps sigfm.c's loop structure and sizes (128 keypoints,
+ * 200 RANSAC iterations), not its exact scoring, so compare strides and
+ * latencies, not scores.
+ *
+ * Usage:
+ *   cancel-bench [--fingers=N] [--subtemplates=N] [--trials=N] [--threshold=S]
+ *
+ * Build:  see Makefile
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "brief-desc.h"
+#include "sigfm-cancel.h"
+#include "sigfm-defaults.h"
+
+/* ================================================================== */
+/* Parameters                                                          */
+/* ================================================================== */
+
+#define DEFAULT_FINGERS     8
+#define DEFAULT_SUBTMPL     20      /* nr_enroll_stages */
+#define DEFAULT_TRIALS      400
+#define DEFAULT_THRESHOLD   SIGFM_SCORE_THRESHOLD
+#define RATIO_TEST          0.80f   /* sigfm.c RATIO_TEST */
+#define RANSAC_ITERS        200     /* doc 15 §11 */
+#define INLIER_PX2          9.0f    /* 3 px */
+#define GRID                4       /* px between pool features: 16 × 20 = 64 × 80 */
+#define COST_REPS           5       /* cost table keeps the fastest of these */
+
+static const unsigned strides[] = { 1, 4, 16, 64 };
+#define N_STRIDES (int)(sizeof(strides) / sizeof(strides[0]))
+
+/* A capture: descriptors plus where each keypoint sits in the frame */
+typedef struct {
+    BriefSet s;
+    float    x[BRIEF_MAX_KP], y[BRIEF_MAX_KP];
+} Frame;
+
+/* ================================================================== */
+/* Synthetic captures with geometry                                    */
+/* ================================================================== */
+
+/* brief-desc.h's finger model plus positions: pool feature k sits on a
+ * GRID-spaced 16 × 20 lattice covering the 64 × 80 sensor, and each
+ * capture applies a small rotation, shift and ±0.7 px jitter.  Spurious
+ * corners get random positions. */
+static void
+capture(const SynthFinger *f, Frame *out, uint64_t *rng)
+{
+    int off = (int)(brief_rng_next(rng) % (SYNTH_POOL - BRIEF_MAX_KP + 1));
+    float th = (float)((brief_rng_unit(rng) - 0.5) * 0.28);     /* ±8° */
+    float tx = (float)((brief_rng_unit(rng) - 0.5) * 8);
+    float ty = (float)((brief_rng_unit(rng) - 0.5) * 8);
+    float c = cosf(th), s = sinf(th);
+
+    out->s.n = BRIEF_MAX_KP;
+    for (int i = 0; i < BRIEF_MAX_KP; i++) {
+        if (brief_rng_unit(rng) < SYNTH_SPURIOUS_P) {
+            brief_random(&out->s.d[i], rng);
+            out->x[i] = (float)(brief_rng_unit(rng) * 64);
+            out->y[i] = (float)(brief_rng_unit(rng) * 80);
+            continue;
+        }
+        int k = off + i;
+        out->s.d[i] = f->pool[k];
+        brief_perturb(&out->s.d[i], SYNTH_FLIP_P, rng);
+        float px = (float)(k % 16 * GRID + GRID / 2) - 32;
+        float py = (float)(k / 16 * GRID + GRID / 2) - 40;
+        out->x[i] = c * px - s * py + 32 + tx + (float)((brief_rng_unit(rng) - 0.5) * 1.4);
+        out->y[i] = s * px + c * py + 40 + ty + (float)((brief_rng_unit(rng) - 0.5) * 1.4);
+    }
+}
+
+/* ================================================================== */
+/* Bounded match: KNN + RANSAC, best-so-far on a stop                  */
+/* ================================================================== */
+
+/* Score = RANSAC's best consensus.  A stop inside KNN has no consensus
+ * yet and returns 0; a stop inside RANSAC returns the best so far, which
+ * only ever grows, so a partial score at or above threshold is a sound
+ * accept and a partial score below it means "unknown". */
+static int
+match_bounded(const Frame *a, const Frame *b, SigfmCancelPoll *p)
+{
+    int ia[BRIEF_MAX_KP], ib[BRIEF_MAX_KP], m = 0;
+
+    for (int i = 0; i < a->s.n; i++) {
+        if (sigfm_cancel_poll(p))
+            return 0;
+        int d1 = 1 << 30, d2 = 1 << 30, j1 = -1;
+        for (int j = 0; j < b->s.n; j++) {
+            int d = brief_hamming(&a->s.d[i], &b->s.d[j]);
+            if (d < d1) { d2 = d1; d1 = d; j1 = j; }
+            else if (d < d2) d2 = d;
+        }
+        if (j1 >= 0 && (float)d1 < RATIO_TEST * (float)d2) {
+            ia[m] = i;
+            ib[m] = j1;
+            m++;
+        }
+    }
+    if (m < 2)
+        return 0;
+
+    /* xorshift32 seeded from the match set, state on the stack (R2) */
+    uint32_t rs = 0x9E3779B9u ^ (uint32_t)(m * 2654435761u);
+    int best = 0;
+    for (int it = 0; it < RANSAC_ITERS; it++) {
+        if (sigfm_cancel_poll(p))
+            break;
+        rs ^= rs << 13; rs ^= rs >> 17; rs ^= rs << 5;
+        int u = (int)(rs % (uint32_t)m);
+        rs ^= rs << 13; rs ^= rs >> 17; rs ^= rs << 5;
+        int v = (int)(rs % (uint32_t)m);
+        if (u == v)
+            continue;
+
+        float ax = a->x[ia[v]] - a->x[ia[u]], ay = a->y[ia[v]] - a->y[ia[u]];
+        float bx = b->x[ib[v]] - b->x[ib[u]], by = b->y[ib[v]] - b->y[ib[u]];
+        if (ax * ax + ay * ay < 16)
+            continue;
+        float th = atan2f(by, bx) - atan2f(ay, ax);
+        float c = cosf(th), s = sinf(th);
+        float tx = b->x[ib[u]] - (c * a->x[ia[u]] - s * a->y[ia[u]]);
+        float ty = b->y[ib[u]] - (s * a->x[ia[u]] + c * a->y[ia[u]]);
+
+        int inliers = 0;
+        for (int k = 0; k < m; k++) {
+            float dx = c * a->x[ia[k]] - s * a->y[ia[k]] + tx - b->x[ib[k]];
+            float dy = s * a->x[ia[k]] + c * a->y[ia[k]] + ty - b->y[ib[k]];
+            inliers += dx * dx + dy * dy < INLIER_PX2;
+        }
+        if (inliers > best)
+            best = inliers;
+    }
+    return best;
+}
+
+/* The driver's sub-template loop; *why = SIGFM_STOP_* or 0 */
+static int
+verify_bounded(const Frame *tmpl, int n, const Frame *probe, const SigfmCancel *c,
+               unsigned stride, int *why)
+{
+    SigfmCancelPoll p;
+    sigfm_cancel_poll_init(&p, c, stride);
+    int best = 0;
+    for (int e = 0; e < n; e++) {
+        if (sigfm_cancel_poll(&p))
+            break;
+        int s = match_bounded(&tmpl[e], probe, &p);
+        if (s > best)
+            best = s;
+    }
+    if (why)
+        *why = p.why;
+    return best;
+}
+
+/* ================================================================== */
+/* Async cancel: a second thread plays the GCancellable handler        */
+/* ================================================================== */
+
+typedef struct {
+    SigfmCancel *c;
+    double       delay_us;
+    double       requested_us;  /* written before the request */
+} Canceller;
+
+static void *
+canceller_run(void *arg)
+{
+    Canceller *k = arg;
+    double until = brief_now_us() + k->delay_us;
+    struct timespec ts = { 0, (long)(k->delay_us * 1000 * 0.8) };
+    nanosleep(&ts, NULL);
+    while (brief_now_us() < until)
+        ;
+    k->requested_us = brief_now_us();
+    sigfm_cancel_request(k->c);
+    return NULL;
+}
+
+/* ================================================================== */
+/* Helpers                                                             */
+/* ================================================================== */
+
+static int
+cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double
+pct(double *v, int n, double q)
+{
+    return n ? v[(int)(q * (n - 1))] : 0;
+}
+
+/* ================================================================== */
+/* Usage                                                               */
+/* ================================================================== */
+
+static void
+usage(const char *argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [--fingers=N] [--subtemplates=N] [--trials=N] [--threshold=S]\n"
+        "\n"
+        "  --fingers=N       synthetic fingers, one template each (default: %d)\n"
+        "  --subtemplates=N  sub-templates per template (default: %d)\n"
+        "  --trials=N        deadline and cancel trials per stride (default: %d)\n"
+        "  --threshold=S     accept score for the best-so-far check (default: %d)\n",
+        argv0, DEFAULT_FINGERS, DEFAULT_SUBTMPL, DEFAULT_TRIALS, DEFAULT_THRESHOLD);
+    exit(1);
+}
+
+/* ================================================================== */
+/* Main                                                                */
+/* ================================================================== */
+
+int
+main(int argc, char *argv[])
+{
+    int fingers = DEFAULT_FINGERS;
+    int n_sub = DEFAULT_SUBTMPL;
+    int trials = DEFAULT_TRIALS;
+    int threshold = DEFAULT_THRESHOLD;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--fingers=", 10) == 0)
+            fingers = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "--subtemplates=", 15) == 0)
+            n_sub = atoi(argv[i] + 15);
+        else if (strncmp(argv[i], "--trials=", 9) == 0)
+            trials = atoi(argv[i] + 9);
+        else if (strncmp(argv[i], "--threshold=", 12) == 0)
+            threshold = atoi(argv[i] + 12);
+        else
+            usage(argv[0]);
+    }
+    if (fingers < 1 || n_sub < 1 || trials < 1)
+        usage(argv[0]);
+
+    Frame *tmpl = malloc((size_t)fingers * n_sub * sizeof(Frame));
+    Frame *probe = malloc((size_t)fingers * sizeof(Frame));
+    int *ref = malloc((size_t)fingers * sizeof(int));
+    double *lat = malloc((size_t)trials * sizeof(double));
+    if (!tmpl || !probe || !ref || !lat) { perror("malloc"); return 1; }
+
+    uint64_t rng = 0xCA9CE1ULL;
+    for (int f = 0; f < fingers; f++) {
+        SynthFinger sf;
+        synth_finger_init(&sf, 7000 + (uint64_t)f);
+        for (int e = 0; e < n_sub; e++)
+            capture(&sf, &tmpl[f * n_sub + e], &rng);
+        capture(&sf, &probe[f], &rng);
+    }
+
+    /* ── Cost of polling, and exactness ─────────────────────────── */
+
+    double base_us = 1e30;
+    for (int r = 0; r < COST_REPS; r++) {
+        double t0 = brief_now_us();
+        for (int f = 0; f < fingers; f++)
+            ref[f] = verify_bounded(&tmpl[f * n_sub], n_sub, &probe[f], NULL, 1, NULL);
+        double us = (brief_now_us() - t0) / fingers;
+        if (us < base_us) base_us = us;
+    }
+
+    int accepts = 0;
+    for (int f = 0; f < fingers; f++)
+        accepts += ref[f] >= threshold;
+    printf("%d fingers × %d sub-templates (synthetic), genuine verify %.0f us, "
+           "%d of %d accept at %d\n",
+           fingers, n_sub, base_us, accepts, fingers, threshold);
+
+    /* No token, token, token + deadline interleaved per repetition, so
+     * drift in the machine's speed hits all three alike */
+    printf("\n%-8s  %12s  %14s  %10s  %16s  %10s\n", "stride", "none us/ver",
+           "token us/ver", "overhead", "+deadline us/ver", "overhead");
+    int mismatches = 0;
+    SigfmCancel idle, armed;
+    sigfm_cancel_init(&idle, 0);
+    sigfm_cancel_init(&armed, sigfm_cancel_now_us() + 3600 * 1000000LL);
+    const SigfmCancel *tokens[3] = { NULL, &idle, &armed };
+    for (int k = 0; k < N_STRIDES; k++) {
+        double us[3] = { 1e30, 1e30, 1e30 };
+        for (int r = 0; r < COST_REPS; r++)
+            for (int v = 0; v < 3; v++) {
+                const SigfmCancel *c = tokens[v];
+                double t0 = brief_now_us();
+                for (int f = 0; f < fingers; f++) {
+                    int s = verify_bounded(&tmpl[f * n_sub], n_sub, &probe[f], c,
+                                           strides[k], NULL);
+                    mismatches += s != ref[f];
+                }
+                double t = (brief_now_us() - t0) / fingers;
+                if (t < us[v]) us[v] = t;
+            }
+        printf("%-8u  %12.0f  %14.0f  %9.1f%%  %16.0f  %9.1f%%\n", strides[k], us[0],
+               us[1], 100 * (us[1] - us[0]) / us[0],
+               us[2], 100 * (us[2] - us[0]) / us[0]);
+    }
+
+    /* ── Deadline: overshoot and best-so-far ────────────────────── */
+
+    printf("\n%-8s  %10s  %10s  %10s  %10s  %14s\n",
+           "stride", "stopped", "p50 us", "p99 us", "max us", "accept so far");
+    for (int k = 0; k < N_STRIDES; k++) {
+        int n_lat = 0, sure = 0;
+        for (int t = 0; t < trials; t++) {
+            int f = t % fingers;
+            SigfmCancel c;
+            int64_t start = sigfm_cancel_now_us();
+            sigfm_cancel_init(&c, start + (int64_t)(brief_rng_unit(&rng) * base_us));
+            int why;
+            int s = verify_bounded(&tmpl[f * n_sub], n_sub, &probe[f], &c, strides[k], &why);
+            double end = (double)sigfm_cancel_now_us();
+            if (why == SIGFM_STOP_DEADLINE) {
+                lat[n_lat++] = end - (double)c.deadline_us;
+                sure += s >= threshold;
+            }
+        }
+        qsort(lat, (size_t)n_lat, sizeof(double), cmp_double);
+        printf("%-8u  %10d  %10.1f  %10.1f  %10.1f  %13.1f%%\n", strides[k], n_lat,
+               pct(lat, n_lat, 0.5), pct(lat, n_lat, 0.99), n_lat ? lat[n_lat - 1] : 0,
+               n_lat ? 100.0 * sure / n_lat : 0);
+    }
+
+    /* ── Cancel from another thread ─────────────────────────────── */
+
+    printf("\n%-8s  %10s  %10s  %10s  %10s\n", "stride", "cancelled", "p50 us", "p99 us", "max us");
+    for (int k = 0; k < N_STRIDES; k++) {
+        int n_lat = 0;
+        for (int t = 0; t < trials / 4; t++) {
+            int f = t % fingers;
+            SigfmCancel c;
+            sigfm_cancel_init(&c, 0);
+            Canceller cn = { .c = &c, .delay_us = brief_rng_unit(&rng) * base_us };
+            pthread_t th;
+            if (pthread_create(&th, NULL, canceller_run, &cn) != 0) {
+                perror("pthread_create");
+                return 1;
+            }
+            int why;
+            verify_bounded(&tmpl[f * n_sub], n_sub, &probe[f], &c, strides[k], &why);
+            double end = brief_now_us();
+            pthread_join(th, NULL);
+            if (why == SIGFM_STOP_CANCELLED)
+                lat[n_lat++] = end - cn.requested_us;
+        }
+        qsort(lat, (size_t)n_lat, sizeof(double), cmp_double);
+        printf("%-8u  %10d  %10.1f  %10.1f  %10.1f\n", strides[k], n_lat,
+               pct(lat, n_lat, 0.5), pct(lat, n_lat, 0.99), n_lat ? lat[n_lat - 1] : 0);
+    }
+
+    printf("\nExactness: %s (%d verifies with a token differ from none)\n",
+           mismatches ? "FAIL" : "OK", mismatches);
+
+    free(lat);
+    free(ref);
+    free(probe);
+    free(tmpl);
+    return mismatches ? 1 : 0;
+}
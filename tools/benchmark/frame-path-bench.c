@@ -0,0 +1,369 @@
+/*
+ * frame-path-bench.c — Decrypted image payload → FpImage data (P14, doc 20 §15)
+ *
+ * Runs synthetic sensor frames from the decrypted TLS record to the 64×80
+ * output along two paths and counts what each copies:
+ *
+ *   current    gnutls_record_recv() into a fresh buffer, g_memdup() of the
+ *              payload, decode into a fresh guint16 frame with the driver's
+ *              per-chunk loop, preprocessing into a crop buffer, then
+ *              fp_image_new() + memcpy() into the image
+ *   zero-copy  record decrypted into a device-owned, 64-byte aligned buffer,
+ *              goodix_decode_frame() into a device-owned aligned frame,
+ *              goodix_preprocess_frame() straight into the image data
+ *
+ * Both paths use the P9 kernel, so the difference is the copies,
+ * allocations and the decode.  The decrypt itself is modelled as one
+ * memcpy() into the destination, the same in both paths, and is not counted
+ * as a copy.  Before timing, goodix_decode_frame() is compared with the
+ * driver loop on random payloads of several lengths, and both paths must
+ * produce identical images for every frame.
+ *
+ * Usage:
+ *   frame-path-bench [--frames=N] [--repeat=N] [--header=N]
+ *
+ * Build:  see Makefile
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "goodix-preprocess.h"
+
+/* ================================================================== */
+/* Defaults                                                            */
+/* ================================================================== */
+
+#define SCAN_WIDTH      88
+#define HEIGHT          80
+#define OUT_WIDTH       64
+#define BOOST           4
+#define N_PIXELS        (SCAN_WIDTH * HEIGHT)
+#define PACKED_BYTES    GOODIX_PACKED_SIZE(N_PIXELS)
+#define ALIGN           64
+
+#define DEFAULT_FRAMES  20
+#define DEFAULT_REPEAT  2000
+
+static double
+now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static uint32_t
+xorshift(uint32_t *s)
+{
+    *s ^= *s << 13; *s ^= *s >> 17; *s ^= *s << 5;
+    return *s;
+}
+
+static void *
+xmalloc(size_t n)
+{
+    void *p = malloc(n);
+    if (!p) { perror("malloc"); exit(1); }
+    return p;
+}
+
+static void *
+xaligned(size_t n)
+{
+    void *p = aligned_alloc(ALIGN, (n + ALIGN - 1) / ALIGN * ALIGN);
+    if (!p) { perror("aligned_alloc"); exit(1); }
+    return p;
+}
+
+/* ================================================================== */
+/* Driver decode (goodixtls5xx_decode_frame)                           */
+/* ================================================================== */
+
+static void
+decode_reference(uint16_t frame[], uint32_t frame_size, const uint8_t *raw_frame)
+{
+    uint16_t *pix = frame;
+    for (uint32_t i = 0; i < frame_size; i += 6) {
+        const uint8_t *chunk = raw_frame + i;
+        *pix++ = ((chunk[0] & 0xf) << 8) + chunk[1];
+        *pix++ = (chunk[3] << 4) + (chunk[0] >> 4);
+        *pix++ = ((chunk[5] & 0xf) << 8) + chunk[2];
+        *pix++ = (chunk[4] << 4) + (chunk[5] >> 4);
+    }
+}
+
+/* Inverse of the decode, for building synthetic payloads */
+static void
+pack_frame(const uint16_t *frame, int n_pixels, uint8_t *packed)
+{
+    for (int c = 0; c < n_pixels / 4; c++) {
+        const uint16_t *p = frame + 4 * c;
+        uint8_t *b = packed + 6 * c;
+        b[0] = (uint8_t)((p[0] >> 8 & 0x0f) | (p[1] & 0x0f) << 4);
+        b[1] = (uint8_t)p[0];
+        b[2] = (uint8_t)p[2];
+        b[3] = (uint8_t)(p[1] >> 4);
+        b[4] = (uint8_t)(p[3] >> 4);
+        b[5] = (uint8_t)((p[2] >> 8 & 0x0f) | (p[3] & 0x0f) << 4);
+    }
+}
+
+/* ================================================================== */
+/* Paths                                                               */
+/* ================================================================== */
+
+typedef struct {
+    uint64_t bytes_copied;
+    uint64_t allocs;
+} Counters;
+
+/* Device-owned buffers of the zero-copy path, allocated once at open */
+typedef struct {
+    uint8_t  *record;       /* decrypted record: header + packed pixels */
+    uint16_t *frame;        /* decoded frame, preprocessed in place */
+} FrameBuf;
+
+/* Stand-in for gnutls_record_recv() writing the plaintext */
+static void
+decrypt(uint8_t *dst, const uint8_t *record, size_t len)
+{
+    memcpy(dst, record, len);
+}
+
+static uint8_t *
+path_current(const uint8_t *record, size_t record_len, size_t header,
+             const uint16_t *cal, Counters *cnt)
+{
+    uint8_t *plain = xmalloc(record_len);
+    decrypt(plain, record, record_len);
+
+    uint8_t *payload = xmalloc(record_len - header);           /* g_memdup */
+    memcpy(payload, plain + header, record_len - header);
+    cnt->bytes_copied += record_len - header;
+
+    uint16_t *frame = xmalloc(N_PIXELS * sizeof(uint16_t));
+    decode_reference(frame, PACKED_BYTES, payload);
+
+    uint8_t *cropped = xmalloc(OUT_WIDTH * HEIGHT);
+    goodix_preprocess_frame(frame, cal, SCAN_WIDTH, HEIGHT, OUT_WIDTH, BOOST, cropped);
+
+    uint8_t *image = xmalloc(OUT_WIDTH * HEIGHT);               /* fp_image_new */
+    memcpy(image, cropped, OUT_WIDTH * HEIGHT);
+    cnt->bytes_copied += OUT_WIDTH * HEIGHT;
+    cnt->allocs += 5;
+
+    free(plain);
+    free(payload);
+    free(frame);
+    free(cropped);
+    return image;
+}
+
+static uint8_t *
+path_zero_copy(FrameBuf *fb, const uint8_t *record, size_t record_len,
+               size_t header, const uint16_t *cal, Counters *cnt)
+{
+    decrypt(fb->record, record, record_len);
+    goodix_decode_frame(fb->record + header, N_PIXELS, fb->frame);
+
+    uint8_t *image = xmalloc(OUT_WIDTH * HEIGHT);               /* fp_image_new */
+    goodix_preprocess_frame(fb->frame, cal, SCAN_WIDTH, HEIGHT, OUT_WIDTH, BOOST, image);
+    cnt->allocs += 1;
+    return image;
+}
+
+/* ================================================================== */
+/* Checks                                                              */
+/* ================================================================== */
+
+/* goodix_decode_frame() vs the driver loop: random bytes, several lengths
+ * so both the vector loop and its scalar tail are covered */
+static int
+check_decode(void)
+{
+    static const int sizes[] = { 4, 8, 12, 16, 20, 28, 44, N_PIXELS };
+    uint32_t rng = 0xdec0de;
+    int failures = 0;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int n = sizes[s];
+        uint8_t *packed = xmalloc(GOODIX_PACKED_SIZE(n));
+        uint16_t *a = xmalloc(n * sizeof(uint16_t));
+        uint16_t *b = xmalloc(n * sizeof(uint16_t));
+        for (int trial = 0; trial < 64; trial++) {
+            for (int i = 0; i < GOODIX_PACKED_SIZE(n); i++)
+                packed[i] = (uint8_t)xorshift(&rng);
+            decode_reference(a, GOODIX_PACKED_SIZE(n), packed);
+            if (goodix_decode_frame(packed, n, b) != 0 ||
+                memcmp(a, b, n * sizeof(uint16_t)) != 0) {
+                fprintf(stderr, "  MISMATCH: decode of %d pixels\n", n);
+                failures++;
+                break;
+            }
+        }
+        free(packed); free(a); free(b);
+    }
+    return failures;
+}
+
+/* ================================================================== */
+/* Synthetic frames                                                    */
+/* ================================================================== */
+
+/* 12-bit calibration frame with a column fixed pattern, and raw frames of
+ * cal + a ridge pattern + read noise, as the sensor delivers them */
+static void
+make_frames(int n_frames, uint16_t *cal, uint16_t *raw)
+{
+    uint32_t rng = 0x5eed;
+    for (int y = 0; y < HEIGHT; y++)
+        for (int x = 0; x < SCAN_WIDTH; x++)
+            cal[y * SCAN_WIDTH + x] = (uint16_t)(1800 + (x * 37 % 23) * 8 + xorshift(&rng) % 16);
+
+    for (int f = 0; f < n_frames; f++) {
+        int period = 6 + f % 4, phase = f * 3;
+        for (int y = 0; y < HEIGHT; y++)
+            for (int x = 0; x < SCAN_WIDTH; x++) {
+                int i = y * SCAN_WIDTH + x;
+                int ridge = ((x + y / 2 + phase) % period) < period / 2 ? 600 : 0;
+                int v = cal[i] + ridge + (int)(xorshift(&rng) % 64) - 32;
+                raw[(size_t)f * N_PIXELS + i] = (uint16_t)(v < 0 ? 0 : v > 0xfff ? 0xfff : v);
+            }
+    }
+}
+
+/* ================================================================== */
+/* Usage                                                               */
+/* ================================================================== */
+
+static void
+usage(const char *argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [--frames=N] [--repeat=N] [--header=N]\n"
+        "\n"
+        "  --frames=N     synthetic frames (default: %d)\n"
+        "  --repeat=N     timed passes over all frames (default: %d)\n"
+        "  --header=N     record bytes before the packed pixels (default: 0)\n",
+        argv0, DEFAULT_FRAMES, DEFAULT_REPEAT);
+    exit(1);
+}
+
+/* ================================================================== */
+/* Main                                                                */
+/* ================================================================== */
+
+int
+main(int argc, char *argv[])
+{
+    int n_frames = DEFAULT_FRAMES;
+    int repeat = DEFAULT_REPEAT;
+    int header = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--frames=", 9) == 0)
+            n_frames = atoi(argv[i] + 9);
+        else if (strncmp(argv[i], "--repeat=", 9) == 0)
+            repeat = atoi(argv[i] + 9);
+        else if (strncmp(argv[i], "--header=", 9) == 0)
+            header = atoi(argv[i] + 9);
+        else
+            usage(argv[0]);
+    }
+    if (n_frames < 1 || repeat < 1 || header < 0)
+        usage(argv[0]);
+
+    const size_t record_len = (size_t)header + PACKED_BYTES;
+    uint16_t *cal = xmalloc(N_PIXELS * sizeof(uint16_t));
+    uint16_t *raw = xmalloc((size_t)n_frames * N_PIXELS * sizeof(uint16_t));
+    uint8_t *records = xmalloc((size_t)n_frames * record_len);
+    make_frames(n_frames, cal, raw);
+    for (int f = 0; f < n_frames; f++) {
+        uint8_t *rec = records + (size_t)f * record_len;
+        memset(rec, 0xa5, (size_t)header);
+        pack_frame(raw + (size_t)f * N_PIXELS, N_PIXELS, rec + header);
+    }
+
+    FrameBuf fb = {
+        .record = xaligned(record_len),
+        .frame  = xaligned(N_PIXELS * sizeof(uint16_t)),
+    };
+
+    printf("frame-path-bench: %d×%d → %d×%d, %zu-byte record (%d header), %d frames × %d\n\n",
+           SCAN_WIDTH, HEIGHT, OUT_WIDTH, HEIGHT, record_len, header, n_frames, repeat);
+
+    /* ── Exactness ─────────────────────────────────────────────── */
+
+    int failures = check_decode();
+    for (int f = 0; f < n_frames; f++) {
+        const uint8_t *rec = records + (size_t)f * record_len;
+        Counters scratch = { 0 };
+        uint8_t *a = path_current(rec, record_len, header, cal, &scratch);
+        uint8_t *b = path_zero_copy(&fb, rec, record_len, header, cal, &scratch);
+        if (memcmp(a, b, OUT_WIDTH * HEIGHT) != 0) {
+            fprintf(stderr, "  MISMATCH: frame %d output\n", f);
+            failures++;
+        }
+        uint16_t check[N_PIXELS];
+        decode_reference(check, PACKED_BYTES, rec + header);
+        if (memcmp(check, raw + (size_t)f * N_PIXELS, sizeof(check)) != 0) {
+            fprintf(stderr, "  MISMATCH: frame %d pack/decode round trip\n", f);
+            failures++;
+        }
+        free(a);
+        free(b);
+    }
+
+    /* ── Decode alone ──────────────────────────────────────────── */
+
+    uint16_t *dec = xaligned(N_PIXELS * sizeof(uint16_t));
+    double t0 = now_us();
+    for (int r = 0; r < repeat; r++)
+        for (int f = 0; f < n_frames; f++)
+            decode_reference(dec, PACKED_BYTES, records + (size_t)f * record_len + header);
+    double t1 = now_us();
+    for (int r = 0; r < repeat; r++)
+        for (int f = 0; f < n_frames; f++)
+            goodix_decode_frame(records + (size_t)f * record_len + header, N_PIXELS, dec);
+    double t2 = now_us();
+    const double scans = (double)repeat * n_frames;
+    printf("  decode          driver loop %6.2f us   goodix_decode_frame %6.2f us\n\n",
+           (t1 - t0) / scans, (t2 - t1) / scans);
+    free(dec);
+
+    /* ── Whole path ────────────────────────────────────────────── */
+
+    Counters cur = { 0 }, zc = { 0 };
+    t0 = now_us();
+    for (int r = 0; r < repeat; r++)
+        for (int f = 0; f < n_frames; f++)
+            free(path_current(records + (size_t)f * record_len, record_len, header, cal, &cur));
+    t1 = now_us();
+    for (int r = 0; r < repeat; r++)
+        for (int f = 0; f < n_frames; f++)
+            free(path_zero_copy(&fb, records + (size_t)f * record_len, record_len, header, cal, &zc));
+    t2 = now_us();
+
+    printf("  %-10s  %10s  %14s  %12s\n", "path", "us/scan", "copied/scan", "allocs/scan");
+    printf("  %-10s  %10.2f  %12.0f B  %12.1f\n", "current",
+           (t1 - t0) / scans, (double)cur.bytes_copied / scans, (double)cur.allocs / scans);
+    printf("  %-10s  %10.2f  %12.0f B  %12.1f\n", "zero-copy",
+           (t2 - t1) / scans, (double)zc.bytes_copied / scans, (double)zc.allocs / scans);
+
+    free(fb.record);
+    free(fb.frame);
+    free(records);
+    free(raw);
+    free(cal);
+    if (failures) {
+        printf("\n  %d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,612 @@
+/*
+ * gallery-cache-bench.c — Decoded-gallery cache vs per-operation decode (P19, doc 20 §20)
+ *
+ * Simulates fprintd sessions: every operation hands the driver all prints
+ * of one user, loaded afresh from disk, and every so often a finger is
+ * re-enrolled (new content, same slot).  Per operation it compares
+ *
+ *   decode     deserialise every print, as today
+ *   full-key   SHA-256 over the serialised data, cache lookup, decode on
+ *              a miss
+ *   fnv-key    64-bit FNV-1a over the serialised data, then the same
+ *   xxh-key    XXH64 over the serialised data, then the same
+ *   meta-key   SHA-256 over the print's metadata and the per-sub-template
+ *              headers plus the first descriptor of each, then the same
+ *
+ * Only meta-key samples the content, so only it removes a re-enrolled
+ * print's entry; the whole-print keys must miss on new content by
+ * themselves, and the old entry ages out.
+ *
+ * The serialised layout is a stand-in for the SIGFM blob: per
+ * sub-template a keypoint count, keypoints (x, y as le16) and 32-byte
+ * BRIEF descriptors.  Its decoder allocates and copies per sub-template
+ * the way sigfm's does, without the GVariant walk in front of it, so the
+ * decode times are a lower bound.  Every hit is checked against the
+ * print's current content; a stale hit makes the tool exit 1.
+ *
+ * Usage:
+ *   gallery-cache-bench [--users=N] [--fingers=N] [--subtemplates=N]
+ *                       [--keypoints=N] [--ops=N] [--reenroll=R]
+ *                       [--cap-kb=K1,K2,...]
+ *
+ * Build:  see Makefile
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "goodix-gallery-cache.h"
+
+/* ================================================================== */
+/* Defaults                                                            */
+/* ================================================================== */
+
+#define DEFAULT_USERS       2
+#define DEFAULT_FINGERS     2
+#define DEFAULT_SUBS        20      /* nr_enroll_stages */
+#define DEFAULT_KP          128     /* sigfm.c MAX_KP */
+#define DEFAULT_OPS         2000
+#define DEFAULT_REENROLL    200     /* one re-enroll every R operations */
+#define MAX_PRINTS          256
+#define MAX_LIST            16
+#define DESC_BYTES          32
+#define KP_BYTES            (4 + DESC_BYTES)
+
+static double
+now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static uint32_t
+xorshift(uint32_t *s)
+{
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+/* ================================================================== */
+/* SHA-256 (FIPS 180-4) — what g_compute_checksum_for_data() runs       */
+/* ================================================================== */
+
+typedef struct {
+    uint32_t h[8];
+    uint8_t  buf[64];
+    uint64_t len;
+} Sha256;
+
+static const uint32_t sha_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void
+sha256_block(Sha256 *s, const uint8_t *p)
+{
+    uint32_t w[64], a, b, c, d, e, f, g, h;
+    for (int i = 0; i < 16; i++)
+        w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 |
+               (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    a = s->h[0]; b = s->h[1]; c = s->h[2]; d = s->h[3];
+    e = s->h[4]; f = s->h[5]; g = s->h[6]; h = s->h[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (ROR(e, 6) ^ ROR(e, 11) ^ ROR(e, 25)) + ((e & f) ^ (~e & g)) + sha_k[i] + w[i];
+        uint32_t t2 = (ROR(a, 2) ^ ROR(a, 13) ^ ROR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    s->h[0] += a; s->h[1] += b; s->h[2] += c; s->h[3] += d;
+    s->h[4] += e; s->h[5] += f; s->h[6] += g; s->h[7] += h;
+}
+
+static void
+sha256_init(Sha256 *s)
+{
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(s->h, iv, sizeof(iv));
+    s->len = 0;
+}
+
+static void
+sha256_update(Sha256 *s, const uint8_t *p, size_t n)
+{
+    size_t fill = s->len % 64;
+    s->len += n;
+    if (fill) {
+        size_t take = 64 - fill < n ? 64 - fill : n;
+        memcpy(s->buf + fill, p, take);
+        p += take; n -= take;
+        if (fill + take < 64)
+            return;
+        sha256_block(s, s->buf);
+    }
+    for (; n >= 64; p += 64, n -= 64)
+        sha256_block(s, p);
+    memcpy(s->buf, p, n);
+}
+
+static void
+sha256_final(Sha256 *s, uint8_t out[32])
+{
+    uint64_t bits = s->len * 8;
+    uint8_t pad[72] = { 0x80 };
+    size_t fill = s->len % 64;
+    size_t n = (fill < 56 ? 56 : 120) - fill;
+    for (int i = 0; i < 8; i++)
+        pad[n + i] = (uint8_t)(bits >> (56 - 8 * i));
+    sha256_update(s, pad, n + 8);
+    for (int i = 0; i < 8; i++)
+        for (int j = 0; j < 4; j++)
+            out[4 * i + j] = (uint8_t)(s->h[i] >> (24 - 8 * j));
+}
+
+/* ================================================================== */
+/* 64-bit non-cryptographic hashes                                     */
+/* ================================================================== */
+
+static uint64_t
+fnv1a64(const uint8_t *p, size_t n)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+/* XXH64 (seed 0), https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md */
+#define XXH_P1  0x9e3779b185ebca87ull
+#define XXH_P2  0xc2b2ae3d27d4eb4full
+#define XXH_P3  0x165667b19e3779f9ull
+#define XXH_P4  0x85ebca77c2b2ae63ull
+#define XXH_P5  0x27d4eb2f165667c5ull
+
+#define ROL64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+/* Little-endian host assumed (x86, arm64); the driver would use
+ * GUINT64_FROM_LE().  Assembling the word from bytes was 2-8x slower. */
+static uint64_t
+le64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t
+xxh64_round(uint64_t acc, uint64_t in)
+{
+    acc += in * XXH_P2;
+    return ROL64(acc, 31) * XXH_P1;
+}
+
+static uint64_t
+xxh64_merge(uint64_t h, uint64_t v)
+{
+    h ^= xxh64_round(0, v);
+    return h * XXH_P1 + XXH_P4;
+}
+
+static uint64_t
+xxh64(const uint8_t *p, size_t n)
+{
+    const uint8_t *end = p + n;
+    uint64_t h;
+
+    if (n >= 32) {
+        uint64_t v1 = XXH_P1 + XXH_P2, v2 = XXH_P2, v3 = 0, v4 = -XXH_P1;
+        for (; end - p >= 32; p += 32) {
+            v1 = xxh64_round(v1, le64(p));
+            v2 = xxh64_round(v2, le64(p + 8));
+            v3 = xxh64_round(v3, le64(p + 16));
+            v4 = xxh64_round(v4, le64(p + 24));
+        }
+        h = ROL64(v1, 1) + ROL64(v2, 7) + ROL64(v3, 12) + ROL64(v4, 18);
+        h = xxh64_merge(h, v1);
+        h = xxh64_merge(h, v2);
+        h = xxh64_merge(h, v3);
+        h = xxh64_merge(h, v4);
+    } else {
+        h = XXH_P5;
+    }
+    h += n;
+    for (; end - p >= 8; p += 8)
+        h = ROL64(h ^ xxh64_round(0, le64(p)), 27) * XXH_P1 + XXH_P4;
+    if (end - p >= 4) {
+        uint64_t w = (uint64_t)p[0] | (uint64_t)p[1] << 8 |
+                     (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24;
+        h = ROL64(h ^ w * XXH_P1, 23) * XXH_P2 + XXH_P3;
+        p += 4;
+    }
+    for (; p < end; p++)
+        h = ROL64(h ^ *p * XXH_P5, 11) * XXH_P1;
+    h ^= h >> 33;
+    h *= XXH_P2;
+    h ^= h >> 29;
+    h *= XXH_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+/* ================================================================== */
+/* Stand-in print: serialised blob + decoder                           */
+/* ================================================================== */
+
+typedef struct {
+    uint8_t *blob;
+    size_t   len;
+    uint32_t version;       /* bumped on re-enroll */
+    char     meta[64];      /* driver/device/finger/user/enroll date */
+} StoredPrint;
+
+typedef struct {
+    int       n_kp;
+    uint16_t *xy;
+    uint8_t  *desc;
+} SubTemplate;
+
+typedef struct {
+    int          n_subs;
+    SubTemplate *subs;
+    uint32_t     version;   /* bench-only: content the value was decoded from */
+    size_t       bytes;
+} Decoded;
+
+static void
+make_print(StoredPrint *p, int idx, int subs, int kp, uint32_t *rng)
+{
+    size_t len = 2 + (size_t)subs * (2 + (size_t)kp * KP_BYTES);
+    free(p->blob);
+    p->blob = malloc(len);
+    if (!p->blob) { perror("malloc"); exit(1); }
+    p->len = len;
+    p->version++;
+    snprintf(p->meta, sizeof(p->meta), "goodixtls511/0/finger%d/user%d/%08x",
+             idx % 10, idx / 10, p->version * 2654435761u);
+
+    uint8_t *b = p->blob;
+    *b++ = (uint8_t)subs; *b++ = (uint8_t)(subs >> 8);
+    for (int s = 0; s < subs; s++) {
+        *b++ = (uint8_t)kp; *b++ = (uint8_t)(kp >> 8);
+        for (size_t i = 0; i < (size_t)kp * KP_BYTES; i++)
+            *b++ = (uint8_t)xorshift(rng);
+    }
+}
+
+static void
+decoded_free(void *v)
+{
+    Decoded *d = v;
+    for (int s = 0; s < d->n_subs; s++) {
+        free(d->subs[s].xy);
+        free(d->subs[s].desc);
+    }
+    free(d->subs);
+    free(d);
+}
+
+static Decoded *
+decode(const StoredPrint *p)
+{
+    const uint8_t *b = p->blob, *end = p->blob + p->len;
+    Decoded *d = calloc(1, sizeof(*d));
+    if (!d) return NULL;
+    d->n_subs = b[0] | b[1] << 8;
+    b += 2;
+    d->subs = calloc((size_t)d->n_subs, sizeof(*d->subs));
+    d->version = p->version;
+    d->bytes = sizeof(*d) + (size_t)d->n_subs * sizeof(*d->subs);
+    for (int s = 0; d->subs && s < d->n_subs; s++) {
+        if (end - b < 2) { decoded_free(d); return NULL; }
+        int n = b[0] | b[1] << 8;
+        b += 2;
+        if (end - b < (ptrdiff_t)n * KP_BYTES) { decoded_free(d); return NULL; }
+        SubTemplate *st = &d->subs[s];
+        st->n_kp = n;
+        st->xy = malloc((size_t)n * 2 * sizeof(uint16_t));
+        st->desc = malloc((size_t)n * DESC_BYTES);
+        if (!st->xy || !st->desc) { decoded_free(d); return NULL; }
+        for (int k = 0; k < n; k++) {
+            st->xy[2 * k] = (uint16_t)(b[4 * k] | b[4 * k + 1] << 8);
+            st->xy[2 * k + 1] = (uint16_t)(b[4 * k + 2] | b[4 * k + 3] << 8);
+        }
+        b += (size_t)n * 4;
+        memcpy(st->desc, b, (size_t)n * DESC_BYTES);
+        b += (size_t)n * DESC_BYTES;
+        d->bytes += (size_t)n * (2 * sizeof(uint16_t) + DESC_BYTES);
+    }
+    if (!d->subs) { free(d); return NULL; }
+    return d;
+}
+
+static void
+key_full(const StoredPrint *p, uint8_t key[GOODIX_GALLERY_KEY])
+{
+    Sha256 s;
+    sha256_init(&s);
+    sha256_update(&s, p->blob, p->len);
+    sha256_final(&s, key);
+}
+
+/* A 64-bit hash of the whole print and its length; the rest is zero */
+static void
+key_hash64(const StoredPrint *p, uint64_t (*hash)(const uint8_t *, size_t),
+           uint8_t key[GOODIX_GALLERY_KEY])
+{
+    uint64_t h = hash(p->blob, p->len);
+    memset(key, 0, GOODIX_GALLERY_KEY);
+    for (int i = 0; i < 8; i++) {
+        key[i] = (uint8_t)(h >> (8 * i));
+        key[8 + i] = (uint8_t)((uint64_t)p->len >> (8 * i));
+    }
+}
+
+/* Metadata + every sub-template's count and first descriptor: a new
+ * enrollment changes the enroll date and every descriptor */
+static void
+key_meta(const StoredPrint *p, uint8_t key[GOODIX_GALLERY_KEY])
+{
+    Sha256 s;
+    sha256_init(&s);
+    sha256_update(&s, (const uint8_t *)p->meta, strlen(p->meta));
+    uint8_t len[8];
+    for (int i = 0; i < 8; i++)
+        len[i] = (uint8_t)((uint64_t)p->len >> (8 * i));
+    sha256_update(&s, len, sizeof(len));
+    const uint8_t *b = p->blob + 2, *end = p->blob + p->len;
+    int subs = p->blob[0] | p->blob[1] << 8;
+    for (int i = 0; i < subs && end - b >= 2; i++) {
+        int n = b[0] | b[1] << 8;
+        size_t sample = 2 + (n > 0 ? 4 + DESC_BYTES : 0);
+        if ((size_t)(end - b) < sample) break;
+        sha256_update(&s, b, sample);
+        b += 2 + (size_t)n * KP_BYTES;
+    }
+    sha256_final(&s, key);
+}
+
+/* ================================================================== */
+/* Simulation                                                          */
+/* ================================================================== */
+
+enum { M_DECODE, M_FULL, M_FNV, M_XXH, M_META, N_MODES };
+static const char *mode_name[N_MODES] = {
+    "decode", "full-key", "fnv-key", "xxh-key", "meta-key"
+};
+
+static void
+make_key(int mode, const StoredPrint *p, uint8_t key[GOODIX_GALLERY_KEY])
+{
+    switch (mode) {
+    case M_FULL: key_full(p, key);              break;
+    case M_FNV:  key_hash64(p, fnv1a64, key);   break;
+    case M_XXH:  key_hash64(p, xxh64, key);     break;
+    case M_META: key_meta(p, key);              break;
+    }
+}
+
+typedef struct {
+    double   us;            /* key + lookup + decode on miss, all operations */
+    double   key_us;
+    double   decode_us;
+    uint64_t stale;
+    GoodixGalleryStats stats;
+} Run;
+
+static int
+simulate(int mode, size_t cap, int users, int fingers, int subs, int kp,
+         int ops, int reenroll, Run *run)
+{
+    static StoredPrint prints[MAX_PRINTS];
+    int n_prints = users * fingers;
+    uint32_t rng = 0x5eed1234u;
+
+    memset(prints, 0, sizeof(prints));
+    for (int i = 0; i < n_prints; i++)
+        make_print(&prints[i], i, subs, kp, &rng);
+
+    GoodixGalleryCache cache;
+    goodix_gallery_cache_init(&cache, cap, decoded_free);
+    memset(run, 0, sizeof(*run));
+
+    uint32_t pick = 0xabcdef01u;
+    Decoded *uncached[MAX_PRINTS];
+
+    for (int op = 0; op < ops; op++) {
+        if (reenroll > 0 && op > 0 && op % reenroll == 0) {
+            int victim = (int)(xorshift(&pick) % (uint32_t)n_prints);
+            /* Only the sampled key needs the driver's explicit removal */
+            if (mode == M_META) {
+                uint8_t key[GOODIX_GALLERY_KEY];
+                key_meta(&prints[victim], key);
+                goodix_gallery_cache_remove(&cache, key);
+            }
+            make_print(&prints[victim], victim, subs, kp, &rng);
+        }
+
+        /* One verify/identify: all fingers of one user */
+        int user = (int)(xorshift(&pick) % (uint32_t)users);
+        int n_unc = 0;
+        goodix_gallery_cache_begin(&cache);
+        double t_op = now_us();
+        for (int f = 0; f < fingers; f++) {
+            StoredPrint *p = &prints[user * fingers + f];
+            Decoded *d = NULL;
+            uint8_t key[GOODIX_GALLERY_KEY];
+
+            if (mode != M_DECODE) {
+                double t0 = now_us();
+                make_key(mode, p, key);
+                run->key_us += now_us() - t0;
+                d = goodix_gallery_cache_lookup(&cache, key);
+                if (d && d->version != p->version)
+                    run->stale++;
+            }
+            if (!d) {
+                double t0 = now_us();
+                d = decode(p);
+                double dt = now_us() - t0;
+                run->decode_us += dt;
+                if (!d) { fprintf(stderr, "decode failed\n"); return -1; }
+                if (mode == M_DECODE ||
+                    goodix_gallery_cache_insert(&cache, key, d, d->bytes, dt) != 0)
+                    uncached[n_unc++] = d;
+            }
+        }
+        /* Values outside the cache live until the operation ends */
+        for (int i = 0; i < n_unc; i++)
+            decoded_free(uncached[i]);
+        run->us += now_us() - t_op;
+    }
+
+    run->stats = cache.stats;
+    goodix_gallery_cache_clear(&cache);
+    for (int i = 0; i < n_prints; i++) {
+        free(prints[i].blob);
+        prints[i].blob = NULL;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* Main                                                                */
+/* ================================================================== */
+
+static int
+parse_list(const char *s, size_t *out, int max)
+{
+    int n = 0;
+    while (*s && n < max) {
+        char *end;
+        long v = strtol(s, &end, 10);
+        if (end == s || v <= 0) return -1;
+        out[n++] = (size_t)v * 1024;
+        s = (*end == ',') ? end + 1 : end;
+    }
+    return n;
+}
+
+static void
+usage(const char *argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [--users=N] [--fingers=N] [--subtemplates=N] [--keypoints=N]\n"
+        "          [--ops=N] [--reenroll=R] [--cap-kb=K1,K2,...]\n"
+        "\n"
+        "  --users=N         users sharing the device (default: %d)\n"
+        "  --fingers=N       enrolled fingers per user (default: %d)\n"
+        "  --subtemplates=N  sub-templates per print (default: %d)\n"
+        "  --keypoints=N     keypoints per sub-template (default: %d)\n"
+        "  --ops=N           verify/identify operations (default: %d)\n"
+        "  --reenroll=R      re-enroll one finger every R operations, 0 = never\n"
+        "                    (default: %d)\n"
+        "  --cap-kb=K,...    cache caps to compare (default: whole gallery, half of it)\n",
+        argv0, DEFAULT_USERS, DEFAULT_FINGERS, DEFAULT_SUBS, DEFAULT_KP,
+        DEFAULT_OPS, DEFAULT_REENROLL);
+    exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int users = DEFAULT_USERS, fingers = DEFAULT_FINGERS;
+    int subs = DEFAULT_SUBS, kp = DEFAULT_KP;
+    int ops = DEFAULT_OPS, reenroll = DEFAULT_REENROLL;
+    size_t caps[MAX_LIST];
+    int n_caps = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--users=", 8) == 0)
+            users = atoi(argv[i] + 8);
+        else if (strncmp(argv[i], "--fingers=", 10) == 0)
+            fingers = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "--subtemplates=", 15) == 0)
+            subs = atoi(argv[i] + 15);
+        else if (strncmp(argv[i], "--keypoints=", 12) == 0)
+            kp = atoi(argv[i] + 12);
+        else if (strncmp(argv[i], "--ops=", 6) == 0)
+            ops = atoi(argv[i] + 6);
+        else if (strncmp(argv[i], "--reenroll=", 11) == 0)
+            reenroll = atoi(argv[i] + 11);
+        else if (strncmp(argv[i], "--cap-kb=", 9) == 0) {
+            n_caps = parse_list(argv[i] + 9, caps, MAX_LIST);
+            if (n_caps <= 0) usage(argv[0]);
+        } else
+            usage(argv[0]);
+    }
+    if (users < 1 || fingers < 1 || users * fingers > MAX_PRINTS ||
+        subs < 1 || subs > 0xffff || kp < 1 || kp > 0xffff || ops < 1 || reenroll < 0)
+        usage(argv[0]);
+
+    /* Size of one decoded print, for the default caps */
+    StoredPrint probe = { 0 };
+    uint32_t rng = 1;
+    make_print(&probe, 0, subs, kp, &rng);
+    Decoded *d = decode(&probe);
+    if (!d) return 1;
+    size_t print_bytes = d->bytes;
+    decoded_free(d);
+    free(probe.blob);
+
+    int n_prints = users * fingers;
+    if (n_caps == 0) {
+        caps[n_caps++] = print_bytes * (size_t)n_prints + 1024;
+        caps[n_caps++] = print_bytes * (size_t)((n_prints + 1) / 2);
+    }
+
+    printf("Gallery: %d users × %d fingers, %d sub-templates × %d keypoints "
+           "(%.0f KB decoded per print); %d operations, re-enroll every %d\n\n",
+           users, fingers, subs, kp, print_bytes / 1024.0, ops, reenroll);
+    printf("%-9s %9s  %10s  %8s  %8s  %7s  %9s  %9s\n", "Mode", "Cap KB", "µs/op",
+           "key µs", "hit %", "evict", "saved µs", "stale");
+
+    int stale = 0;
+    for (int c = 0; c < n_caps; c++) {
+        for (int m = 0; m < N_MODES; m++) {
+            if (m == M_DECODE && c > 0)
+                continue;
+            Run r;
+            if (simulate(m, caps[c], users, fingers, subs, kp, ops, reenroll, &r) != 0)
+                return 1;
+            uint64_t look = r.stats.hits + r.stats.misses;
+            char cap_kb[24] = "-";
+            if (m != M_DECODE)
+                snprintf(cap_kb, sizeof(cap_kb), "%zu", caps[c] / 1024);
+            printf("%-9s %9s  %10.1f  %8.1f  %8.1f  %7llu  %9.1f  %9llu\n",
+                   mode_name[m], cap_kb, r.us / ops, r.key_us / ops,
+                   look ? 100.0 * r.stats.hits / look : 0.0,
+                   (unsigned long long)r.stats.evictions,
+                   r.stats.saved_us / ops, (unsigned long long)r.stale);
+            stale += r.stale > 0;
+        }
+    }
+    printf("\nStale hits: %s\n", stale ? "FOUND" : "none");
+    return stale ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * goodix-gallery-cache.c — Decoded-print cache across operations (P19, doc 20 §20)
+ *
+ * See goodix-gallery-cache.h.  A gallery is a handful of prints, so the
+ * entries are one doubly-linked list in recency order and lookup is a
+ * linear scan of 32-byte keys — no hash table to size or grow.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "goodix-gallery-cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct GoodixGalleryEntry {
+    GoodixGalleryEntry *prev, *next;
+    uint8_t             key[GOODIX_GALLERY_KEY];
+    void               *value;
+    size_t              bytes;
+    double              decode_us;
+    uint32_t            op;         /* last operation that used it */
+};
+
+static void
+unlink_entry(GoodixGalleryCache *c, GoodixGalleryEntry *e)
+{
+    if (e->prev) e->prev->next = e->next; else c->head = e->next;
+    if (e->next) e->next->prev = e->prev; else c->tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void
+push_front(GoodixGalleryCache *c, GoodixGalleryEntry *e)
+{
+    e->prev = NULL;
+    e->next = c->head;
+    if (c->head) c->head->prev = e; else c->tail = e;
+    c->head = e;
+}
+
+static void
+drop(GoodixGalleryCache *c, GoodixGalleryEntry *e)
+{
+    unlink_entry(c, e);
+    c->stats.bytes -= e->bytes;
+    c->stats.entries--;
+    if (c->free_value)
+        c->free_value(e->value);
+    free(e);
+}
+
+static GoodixGalleryEntry *
+find(GoodixGalleryCache *c, const uint8_t *key)
+{
+    for (GoodixGalleryEntry *e = c->head; e; e = e->next)
+        if (memcmp(e->key, key, GOODIX_GALLERY_KEY) == 0)
+            return e;
+    return NULL;
+}
+
+void
+goodix_gallery_cache_init(GoodixGalleryCache *c, size_t max_bytes,
+                          GoodixGalleryFree free_value)
+{
+    memset(c, 0, sizeof(*c));
+    c->max_bytes = max_bytes;
+    c->free_value = free_value;
+    c->op = 1;
+}
+
+void
+goodix_gallery_cache_clear(GoodixGalleryCache *c)
+{
+    while (c->head)
+        drop(c, c->head);
+}
+
+void
+goodix_gallery_cache_begin(GoodixGalleryCache *c)
+{
+    c->op++;
+}
+
+void *
+goodix_gallery_cache_lookup(GoodixGalleryCache *c, const uint8_t key[GOODIX_GALLERY_KEY])
+{
+    GoodixGalleryEntry *e = find(c, key);
+    if (!e) {
+        c->stats.misses++;
+        return NULL;
+    }
+    c->stats.hits++;
+    c->stats.saved_us += e->decode_us;
+    e->op = c->op;
+    if (e != c->head) {
+        unlink_entry(c, e);
+        push_front(c, e);
+    }
+    return e->value;
+}
+
+int
+goodix_gallery_cache_insert(GoodixGalleryCache *c, const uint8_t key[GOODIX_GALLERY_KEY],
+                            void *value, size_t bytes, double decode_us)
+{
+    /* Same content inserted twice: keep the one already shared */
+    GoodixGalleryEntry *old = find(c, key);
+    if (old && old->op == c->op)
+        return -1;
+    if (old)
+        drop(c, old);
+
+    /* Evict from the cold end, skipping entries this operation uses */
+    GoodixGalleryEntry *e = c->tail;
+    while (e && c->stats.bytes + bytes > c->max_bytes) {
+        GoodixGalleryEntry *prev = e->prev;
+        if (e->op != c->op) {
+            drop(c, e);
+            c->stats.evictions++;
+        }
+        e = prev;
+    }
+    if (c->stats.bytes + bytes > c->max_bytes) {
+        c->stats.refused++;
+        return -1;
+    }
+
+    GoodixGalleryEntry *n = calloc(1, sizeof(*n));
+    if (!n)
+        return -1;
+    memcpy(n->key, key, GOODIX_GALLERY_KEY);
+    n->value = value;
+    n->bytes = bytes;
+    n->decode_us = decode_us;
+    n->op = c->op;
+    push_front(c, n);
+    c->stats.bytes += bytes;
+    c->stats.entries++;
+    return 0;
+}
+
+int
+goodix_gallery_cache_remove(GoodixGalleryCache *c, const uint8_t key[GOODIX_GALLERY_KEY])
+{
+    GoodixGalleryEntry *e = find(c, key);
+    if (!e)
+        return 0;
+    drop(c, e);
+    return 1;
+}
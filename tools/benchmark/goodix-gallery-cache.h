@@ -0,0 +1,86 @@
+/*
+ * goodix-gallery-cache.h — Decoded-print cache across operations (P19, doc 20 §20)
+ *
+ * fprintd hands the same stored prints to every verify and identify, and
+ * the driver deserialises each one's SIGFM data every time.  This cache
+ * keeps the decoded, match-ready value between operations, with a byte
+ * cap and least-recently-used eviction.
+ *
+ * The key is a 32-byte digest chosen by the caller.  The driver keys on
+ * the whole serialised print: its XXH64 and its length, the rest zero.
+ * SHA-256 over a print costs ~75x its decode and a sampled key cannot
+ * guarantee that a re-enrolled print misses; XXH64 costs about one decode
+ * and a changed print misses unless its 64-bit hash collides.  Stale
+ * entries then age out on their own, so goodix_gallery_cache_remove() on
+ * delete and goodix_gallery_cache_clear() after an enrollment only free
+ * the memory early.
+ *
+ * Entries looked up or inserted since the last goodix_gallery_cache_begin()
+ * are pinned: an operation that is still using them cannot have them
+ * evicted under it.  When only pinned entries are left and a new value
+ * does not fit, insert refuses it and the caller frees it after the
+ * operation.
+ *
+ * Not thread-safe; the driver uses it from the device's main context only
+ * (identify workers read values, never the cache).  Plain C99 + stdint so
+ * the same file builds in the driver and in tools/.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef GOODIX_GALLERY_CACHE_H
+#define GOODIX_GALLERY_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GOODIX_GALLERY_KEY  32      /* room for SHA-256; the driver uses 16 */
+
+typedef void (*GoodixGalleryFree) (void *value);
+
+typedef struct GoodixGalleryEntry GoodixGalleryEntry;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t refused;           /* insert did not fit past the pinned entries */
+    double   saved_us;          /* decode time of every hit, as measured at insert */
+    size_t   bytes;
+    size_t   entries;
+} GoodixGalleryStats;
+
+typedef struct {
+    GoodixGalleryEntry *head;   /* most recently used */
+    GoodixGalleryEntry *tail;
+    size_t              max_bytes;
+    uint32_t            op;     /* current operation, for pinning */
+    GoodixGalleryFree   free_value;
+    GoodixGalleryStats  stats;
+} GoodixGalleryCache;
+
+void   goodix_gallery_cache_init   (GoodixGalleryCache *c, size_t max_bytes,
+                                    GoodixGalleryFree free_value);
+/* Frees every value */
+void   goodix_gallery_cache_clear  (GoodixGalleryCache *c);
+
+/* Start of a verify/identify: unpins the previous operation's entries */
+void   goodix_gallery_cache_begin  (GoodixGalleryCache *c);
+
+/* The cached value, or NULL (counted as a miss).  A hit becomes most
+ * recently used and is pinned for the current operation. */
+void  *goodix_gallery_cache_lookup (GoodixGalleryCache *c,
+                                    const uint8_t key[GOODIX_GALLERY_KEY]);
+
+/* Takes ownership of value on 0.  `bytes` is what it counts against the
+ * cap, `decode_us` what a later hit saves.  −1 when it does not fit (or
+ * on ENOMEM): ownership stays with the caller. */
+int    goodix_gallery_cache_insert (GoodixGalleryCache *c,
+                                    const uint8_t key[GOODIX_GALLERY_KEY],
+                                    void *value, size_t bytes, double decode_us);
+
+/* Drop one entry (print deleted or re-enrolled); 1 if it was cached */
+int    goodix_gallery_cache_remove (GoodixGalleryCache *c,
+                                    const uint8_t key[GOODIX_GALLERY_KEY]);
+
+#endif /* GOODIX_GALLERY_CACHE_H */
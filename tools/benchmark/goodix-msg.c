@@ -0,0 +1,173 @@
+/*
+ * goodix-msg.c — Goodix message assembly for the USB receive path (P15, doc 20 §16)
+ *
+ * See goodix-msg.h.  `msg-replay` compares it message by message with a
+ * model of the goodix.c receive path.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "goodix-msg.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static inline size_t
+le16(const uint8_t *p)
+{
+    return (size_t)p[0] | (size_t)p[1] << 8;
+}
+
+int
+goodix_msg_rx_init(GoodixMsgRx *rx, size_t min_cap, size_t max_transfer)
+{
+    memset(rx, 0, sizeof(*rx));
+    rx->xfer = max_transfer;
+    /* bytes that followed a finished message (under one transfer) plus
+     * the next transfer must fit before the next header is read */
+    if (min_cap < 2 * max_transfer)
+        min_cap = 2 * max_transfer;
+    rx->cap = min_cap > GOODIX_PACK_HEADER ? min_cap : GOODIX_PACK_HEADER;
+    rx->buf = malloc(rx->cap);
+    if (!rx->buf) {
+        rx->cap = 0;
+        return -1;
+    }
+    goodix_msg_rx_reset(rx);
+    return 0;
+}
+
+void
+goodix_msg_rx_free(GoodixMsgRx *rx)
+{
+    free(rx->buf);
+    memset(rx, 0, sizeof(*rx));
+}
+
+void
+goodix_msg_rx_reset(GoodixMsgRx *rx)
+{
+    rx->len = rx->need = rx->done = 0;
+    rx->summed = GOODIX_PACK_HEADER;
+    rx->sum = 0;
+}
+
+/* Forget the message handed out last; bytes that followed it in the same
+ * transfer become the start of the next one. */
+static void
+drop_done(GoodixMsgRx *rx)
+{
+    if (rx->done == 0)
+        return;
+    memmove(rx->buf, rx->buf + rx->done, rx->len - rx->done);
+    rx->len -= rx->done;
+    rx->need = rx->done = 0;
+    rx->summed = GOODIX_PACK_HEADER;
+    rx->sum = 0;
+}
+
+/* Read the pack header once it is in and add newly arrived protocol bytes
+ * (cmd, length, data — not the checksum byte) to the running sum. */
+static void
+update(GoodixMsgRx *rx)
+{
+    const uint8_t *b = rx->buf;
+
+    if (rx->need == 0 && rx->len >= GOODIX_PACK_HEADER)
+        rx->need = GOODIX_PACK_HEADER + le16(b + 1);
+
+    if (rx->need == 0 || b[0] != GOODIX_FLAGS_MSG_PROTOCOL ||
+        rx->len < GOODIX_PACK_HEADER + GOODIX_PROTOCOL_HEADER)
+        return;
+
+    size_t end = GOODIX_PACK_HEADER + GOODIX_PROTOCOL_HEADER + le16(b + GOODIX_PACK_HEADER + 1);
+    end = end > 0 ? end - 1 : 0;
+    if (end > rx->need) end = rx->need;
+    if (end > rx->len) end = rx->len;
+
+    uint32_t sum = rx->sum;
+    for (size_t i = rx->summed; i < end; i++)
+        sum += b[i];
+    rx->sum = sum;
+    if (end > rx->summed)
+        rx->summed = end;
+}
+
+static int
+grow(GoodixMsgRx *rx, size_t want)
+{
+    if (want <= rx->cap)
+        return 0;
+    size_t cap = rx->cap ? rx->cap : 64;
+    while (cap < want)
+        cap <<= 1;
+    uint8_t *buf = realloc(rx->buf, cap);
+    if (!buf)
+        return -1;
+    rx->buf = buf;
+    rx->cap = cap;
+    return 0;
+}
+
+size_t
+goodix_msg_rx_span(GoodixMsgRx *rx, uint8_t **ptr)
+{
+    drop_done(rx);
+    *ptr = rx->buf + rx->len;
+    return rx->cap - rx->len;
+}
+
+int
+goodix_msg_rx_commit(GoodixMsgRx *rx, size_t n)
+{
+    if (n > rx->cap - rx->len)
+        n = rx->cap - rx->len;
+    rx->len += n;
+    update(rx);
+    /* room for the rest of this message and the next transfer's overflow */
+    return rx->need ? grow(rx, rx->need + rx->xfer) : 0;
+}
+
+int
+goodix_msg_rx_push(GoodixMsgRx *rx, const uint8_t *chunk, size_t n)
+{
+    drop_done(rx);
+    if (grow(rx, rx->len + n) != 0)
+        return -1;
+    memcpy(rx->buf + rx->len, chunk, n);
+    return goodix_msg_rx_commit(rx, n);
+}
+
+int
+goodix_msg_rx_next(GoodixMsgRx *rx, GoodixMsg *msg)
+{
+    drop_done(rx);
+    update(rx);
+    if (rx->need == 0 || rx->len < rx->need)
+        return 0;
+
+    const uint8_t *b = rx->buf;
+    memset(msg, 0, sizeof(*msg));
+    msg->flags = b[0];
+    msg->payload = b + GOODIX_PACK_HEADER;
+    msg->len = rx->need - GOODIX_PACK_HEADER;
+    msg->pack_ok = (uint8_t)(b[0] + b[1] + b[2]) == b[3];
+    msg->protocol_ok = -1;
+
+    if (msg->flags == GOODIX_FLAGS_MSG_PROTOCOL) {
+        const uint8_t *p = msg->payload;
+        size_t plen = msg->len >= GOODIX_PROTOCOL_HEADER ? le16(p + 1) : 0;
+        msg->protocol_ok = 0;
+        if (plen >= 1 && GOODIX_PROTOCOL_HEADER + plen <= msg->len) {
+            uint8_t checksum = p[GOODIX_PROTOCOL_HEADER + plen - 1];
+            msg->cmd = p[0];
+            msg->data = p + GOODIX_PROTOCOL_HEADER;
+            msg->data_len = plen - 1;
+            msg->protocol_ok = checksum == GOODIX_PROTOCOL_NO_CHECKSUM ||
+                               checksum == (uint8_t)(0xaa - rx->sum);
+        }
+    }
+
+    rx->done = rx->need;
+    return 1;
+}
@@ -0,0 +1,92 @@
+/*
+ * goodix-msg.h — Goodix message assembly for the USB receive path (P15, doc 20 §16)
+ *
+ * Replaces the append-and-retry receive in goodix.c, where every bulk
+ * transfer is g_realloc()'d onto priv->data, goodix_decode_pack() is tried
+ * on the whole buffer and the pack and protocol payloads are g_memdup()'d
+ * before dispatch.  Here one buffer, owned by the receiver and reused for
+ * every message, is sized from the pack header when it arrives; USB
+ * transfers land in it directly (goodix_msg_rx_span() + _commit()), the
+ * checksum is summed over each transfer as it lands, and a complete
+ * message is handed out as pointers into the buffer.
+ *
+ * Framing, as in goodix.c and goodix-fp-dump:
+ *
+ *   pack      flags, length (le16), sum8(flags, length) — then `length`
+ *             payload bytes.  0xa0 carries a protocol message, 0xb0 TLS
+ *             records.
+ *   protocol  cmd, length (le16, data + checksum byte), data, checksum:
+ *             0xaa − sum8(cmd … last data byte), or 0x88 for "none".
+ *
+ * Not thread-safe; the driver uses it from the device's main context only.
+ * Plain C99 + stdint so the same file builds in the driver and in tools/.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef GOODIX_MSG_H
+#define GOODIX_MSG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GOODIX_PACK_HEADER          4
+#define GOODIX_PROTOCOL_HEADER      3
+#define GOODIX_FLAGS_MSG_PROTOCOL   0xa0
+#define GOODIX_FLAGS_TLS            0xb0
+#define GOODIX_PROTOCOL_NO_CHECKSUM 0x88
+
+typedef struct {
+    uint8_t        flags;
+    const uint8_t *payload;     /* pack payload, inside the receive buffer */
+    size_t         len;
+    int            pack_ok;     /* header checksum matched */
+
+    /* flags == GOODIX_FLAGS_MSG_PROTOCOL only */
+    uint8_t        cmd;
+    const uint8_t *data;        /* protocol data, without the checksum byte */
+    size_t         data_len;
+    int            protocol_ok; /* 1 valid, 0 bad checksum or length, −1 not protocol */
+} GoodixMsg;
+
+typedef struct {
+    uint8_t *buf;
+    size_t   cap;
+    size_t   len;       /* bytes received, from the start of the current message */
+    size_t   need;      /* current message size once the header is in, else 0 */
+    size_t   done;      /* bytes handed out by the last goodix_msg_rx_next() */
+    size_t   summed;    /* end of the bytes already added to sum */
+    uint32_t sum;       /* protocol checksum so far */
+    size_t   xfer;      /* largest USB transfer: room kept past a message */
+} GoodixMsgRx;
+
+/* min_cap should cover the largest message (image) plus one USB transfer
+ * so the buffer never grows after open.  max_transfer is the largest bulk
+ * transfer the caller submits; the buffer always keeps that much room past
+ * the current message, so a transfer that ends one message and starts the
+ * next still fits the span.  Returns 0, −1 on ENOMEM. */
+int    goodix_msg_rx_init   (GoodixMsgRx *rx, size_t min_cap, size_t max_transfer);
+void   goodix_msg_rx_free   (GoodixMsgRx *rx);
+
+/* Drop any partial message (timeout, reset_state) */
+void   goodix_msg_rx_reset  (GoodixMsgRx *rx);
+
+/* Where the next USB transfer should land and how many bytes fit.  The
+ * payload of a message returned by goodix_msg_rx_next() stays valid until
+ * this, _commit() or _push() is called. */
+size_t goodix_msg_rx_span   (GoodixMsgRx *rx, uint8_t **ptr);
+
+/* Account for `n` bytes the transfer wrote at the span; grows the buffer
+ * if the header announces a message that, plus one max_transfer, is larger
+ * than it.  −1 on ENOMEM. */
+int    goodix_msg_rx_commit (GoodixMsgRx *rx, size_t n);
+
+/* Copy-in variant of span + commit, for chunks already held elsewhere */
+int    goodix_msg_rx_push   (GoodixMsgRx *rx, const uint8_t *chunk, size_t n);
+
+/* 1 and fills *msg when a complete message is buffered, else 0.  Call in a
+ * loop after each commit: a transfer can end one message and start the
+ * next. */
+int    goodix_msg_rx_next   (GoodixMsgRx *rx, GoodixMsg *msg);
+
+#endif /* GOODIX_MSG_H */
@@ -0,0 +1,265 @@
+/*
+ * goodix-preprocess.c — Fused goodix5xx frame preprocessing (P9, doc 20 §10)
+ *
+ * See goodix-preprocess.h.  Every step reproduces the integer arithmetic of
+ * the multi-pass reference (replay-pipeline.c, copied from goodix5xx.c)
+ * exactly; `replay-pipeline --check` compares the two on every frame.
+ * goodix_decode_frame() is checked against the driver's scalar loop by
+ * `frame-path-bench`.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "goodix-preprocess.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define GOODIX_DECODE_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+/* ================================================================== */
+/* 12-bit unpack                                                       */
+/* ================================================================== */
+
+/* GCC vectorises the four stores of a chunk but not the loop (6-byte load
+ * groups), so x86-64 gets an explicit SSSE3 path, picked at run time: the
+ * driver is built for baseline x86-64, where a compile-time __SSSE3__ test
+ * would never be true. */
+static void
+decode_chunks(const uint8_t *restrict packed, int n_chunks, uint16_t *restrict frame)
+{
+    for (int c = 0; c < n_chunks; c++) {
+        const uint8_t *b = packed + 6 * c;
+        uint16_t *p = frame + 4 * c;
+        p[0] = (uint16_t)((b[0] & 0x0f) << 8 | b[1]);
+        p[1] = (uint16_t)(b[3] << 4 | b[0] >> 4);
+        p[2] = (uint16_t)((b[5] & 0x0f) << 8 | b[2]);
+        p[3] = (uint16_t)(b[4] << 4 | b[5] >> 4);
+    }
+}
+
+#ifdef GOODIX_DECODE_SSSE3
+/* Two chunks (12 bytes → 8 pixels) per 16-byte load.  The shuffle builds
+ * one 16-bit lane per pixel: even lanes b0:b1 / b5:b2 keep their low 12
+ * bits (p0, p2), odd lanes b3:b0 / b4:b5 are shifted right by 4 (p1, p3).
+ * The load reads 4 bytes past the pair, so the last two chunks go through
+ * the scalar loop. */
+__attribute__((target("ssse3")))
+static void
+decode_chunks_ssse3(const uint8_t *restrict packed, int n_chunks,
+                    uint16_t *restrict frame)
+{
+    const __m128i shuf = _mm_setr_epi8(1, 0, 0, 3, 2, 5, 5, 4,
+                                       7, 6, 6, 9, 8, 11, 11, 10);
+    const __m128i even = _mm_set1_epi32(0x0000ffff);
+    const __m128i low12 = _mm_set1_epi16(0x0fff);
+
+    int c = 0;
+    for (; c + 2 < n_chunks; c += 2) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(packed + 6 * c));
+        __m128i s = _mm_shuffle_epi8(v, shuf);
+        __m128i lo = _mm_and_si128(_mm_and_si128(s, low12), even);
+        __m128i hi = _mm_andnot_si128(even, _mm_srli_epi16(s, 4));
+        _mm_storeu_si128((__m128i *)(frame + 4 * c), _mm_or_si128(lo, hi));
+    }
+    decode_chunks(packed + 6 * c, n_chunks - c, frame + 4 * c);
+}
+#endif
+
+int
+goodix_decode_frame(const uint8_t *packed, int n_pixels, uint16_t *frame)
+{
+    if (n_pixels < 4 || n_pixels % 4 != 0)
+        return -1;
+
+#ifdef GOODIX_DECODE_SSSE3
+    if (__builtin_cpu_supports("ssse3")) {
+        decode_chunks_ssse3(packed, n_pixels / 4, frame);
+        return 0;
+    }
+#endif
+    decode_chunks(packed, n_pixels / 4, frame);
+    return 0;
+}
+
+/* ================================================================== */
+/* Stretch parameters                                                  */
+/* ================================================================== */
+
+typedef struct {
+    int      percentile;    /* 0 = degenerate histogram, linear min/max */
+    int      plo;           /* percentile: black level (multiple of 256) */
+    int      range;         /* percentile: white − black level */
+    uint64_t recip;         /* ⌊2^44 / range⌋ + 1, see stretch_px() */
+    int      mn, mx;        /* linear fallback */
+} Stretch;
+
+#define RECIP_SHIFT 44
+
+/* v × 255 / range for 0 < v < range.  range is a multiple of 256 in
+ * [256, 65280] and v × 255 < 2^24, so with a 44-bit reciprocal the
+ * rounding error stays below 2^40 / 2^44 and the quotient is exact. */
+static inline uint8_t
+stretch_px(int f, const Stretch *s)
+{
+    if (s->percentile) {
+        int v = f - s->plo;
+        if (v <= 0) return 0;
+        if (v >= s->range) return 255;
+        return (uint8_t)(((uint64_t)v * 255u * s->recip) >> RECIP_SHIFT);
+    }
+    if (f - s->mn == 0 || s->mx - s->mn == 0)
+        return 0;
+    return (uint8_t)((f - s->mn) * 0xff / (s->mx - s->mn));
+}
+
+/* Same percentile search as squash_frame_percentile() */
+static void
+stretch_init(Stretch *s, const uint32_t *hist, uint32_t frame_size, int mn, int mx)
+{
+    uint32_t target_lo = (frame_size * 1u + 999u) / 1000u;
+    uint32_t count = 0;
+    int bin_lo = 0;
+    for (int b = 0; b < 256; b++) {
+        count += hist[b];
+        if (count >= target_lo) { bin_lo = b; break; }
+    }
+
+    uint32_t target_hi = (frame_size * 99u) / 100u;
+    count = 0;
+    int bin_hi = 255;
+    for (int b = 255; b >= 0; b--) {
+        count += hist[b];
+        if (frame_size - count <= target_hi) { bin_hi = b; break; }
+    }
+
+    memset(s, 0, sizeof(*s));
+    s->mn = mn;
+    s->mx = mx;
+    if (bin_hi > bin_lo) {
+        s->percentile = 1;
+        s->plo = bin_lo << 8;
+        s->range = (bin_hi << 8) - s->plo;
+        s->recip = ((uint64_t)1 << RECIP_SHIFT) / (uint64_t)s->range + 1;
+    }
+}
+
+/* ================================================================== */
+/* Fused kernel                                                        */
+/* ================================================================== */
+
+/* Stretch columns 0 … n−1 of one row, then the horizontal [1 2 1] sum
+ * over columns 0 … n_out−1 (missing neighbours at the frame edge are
+ * skipped, as in the reference blur). */
+static void
+stretch_row(const uint16_t *src, int n, int n_out, int scan_width,
+            const Stretch *s, uint8_t *sq, uint16_t *hs)
+{
+    for (int x = 0; x < n; x++)
+        sq[x] = stretch_px(src[x], s);
+
+    for (int x = 0; x < n_out; x++) {
+        int v = 2 * sq[x];
+        if (x > 0) v += sq[x - 1];
+        if (x + 1 < scan_width) v += sq[x + 1];
+        hs[x] = (uint16_t)v;
+    }
+}
+
+int
+goodix_preprocess_frame(uint16_t *frame, const uint16_t *cal,
+                        int scan_width, int height, int out_width, int boost,
+                        uint8_t *out)
+{
+    if (scan_width < 1 || scan_width > GOODIX_PP_MAX_WIDTH || height < 1 ||
+        out_width < 1 || out_width > scan_width ||
+        (long)scan_width * height > 0xffff)
+        return -1;
+
+    const int n = scan_width * height;
+
+    /* ── Pass 1: subtract + histogram + min/max ─────────────────── */
+
+    uint32_t hist[256] = { 0 };
+    int mn = 0xffff, mx = 0;
+    for (int i = 0; i < n; i++) {
+        uint16_t v = frame[i];
+        if (cal)    /* linear_subtract_inplace(), incl. its uint16 wrap */
+            v = (uint16_t)(0xffff - (int)cal[i] + (int)v);
+        frame[i] = v;
+        hist[v >> 8]++;
+        if (v < mn) mn = v;
+        if (v > mx) mx = v;
+    }
+
+    Stretch s;
+    stretch_init(&s, hist, (uint32_t)n, mn, mx);
+
+    /* ── Pass 2, no unsharp: stretch the retained columns only ──── */
+
+    if (boost <= 0) {
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < out_width; x++)
+                out[y * out_width + x] = stretch_px(frame[y * scan_width + x], &s);
+        return 0;
+    }
+
+    /* ── Pass 2: rolling 3-row window ────────────────────────────
+     * Output column out_width−1 still needs its right neighbour, so rows
+     * are stretched one column past the crop; nothing further right can
+     * reach the output. */
+
+    const int n_sq = out_width < scan_width ? out_width + 1 : scan_width;
+    uint8_t  sq[3][GOODIX_PP_MAX_WIDTH];
+    uint16_t hs[3][GOODIX_PP_MAX_WIDTH];
+
+    stretch_row(frame, n_sq, out_width, scan_width, &s, sq[0], hs[0]);
+
+    for (int y = 0; y < height; y++) {
+        const int cur = y % 3, prev = (y + 2) % 3, next = (y + 1) % 3;
+        if (y + 1 < height)
+            stretch_row(frame + (y + 1) * scan_width, n_sq, out_width, scan_width,
+                        &s, sq[next], hs[next]);
+
+        const int has_up = y > 0, has_down = y + 1 < height;
+        const int wy = 2 + has_up + has_down;
+        uint8_t *dst = out + y * out_width;
+
+        for (int x = 0; x < out_width; x++) {
+            int sum = 2 * hs[cur][x];
+            if (has_up) sum += hs[prev][x];
+            if (has_down) sum += hs[next][x];
+
+            int wx = 2 + (x > 0) + (x + 1 < scan_width);
+            int weight = wx * wy;
+            int blur = weight == 16 ? sum >> 4 : sum / weight;
+
+            int v = boost * (int)sq[cur][x] - (boost - 1) * blur;
+            dst[x] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+        }
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* Calibration drift                                                   */
+/* ================================================================== */
+
+int
+goodix_cal_guard_drift(const uint16_t *raw, const uint16_t *cal,
+                       int scan_width, int height, int guard_x0)
+{
+    if (guard_x0 < 0 || guard_x0 >= scan_width || height < 1)
+        return 0;
+
+    int64_t sum = 0;
+    for (int y = 0; y < height; y++)
+        for (int x = guard_x0; x < scan_width; x++) {
+            int d = (int)raw[y * scan_width + x] - (int)cal[y * scan_width + x];
+            sum += d < 0 ? -d : d;
+        }
+
+    return (int)(sum / ((int64_t)(scan_width - guard_x0) * height));
+}
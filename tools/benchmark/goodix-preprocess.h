@@ -0,0 +1,80 @@
+/*
+ * goodix-preprocess.h — Fused goodix5xx frame preprocessing (P9, doc 20 §10)
+ *
+ * One call replaces the driver's linear_subtract_inplace() →
+ * squash_frame_percentile() → unsharp_mask_inplace() → crop_frame()
+ * sequence with bit-identical output:
+ *
+ *   pass 1   calibration subtract, 256-bin histogram and min/max
+ *   pass 2   per output row: stretch the rows it needs, 3×3 blur from a
+ *            rolling 3-row window of horizontal sums, unsharp, and store
+ *            only the out_width retained columns
+ *
+ * No heap allocation; scratch is a few rows on the stack, so the function
+ * is reentrant (P7).  Plain C99 + stdint so the same file builds in the
+ * driver and in tools/.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef GOODIX_PREPROCESS_H
+#define GOODIX_PREPROCESS_H
+
+#include <stdint.h>
+
+/* Widest scan line supported by the on-stack row scratch */
+#define GOODIX_PP_MAX_WIDTH     256
+
+/* Bytes of sensor payload holding n_pixels packed 12-bit pixels */
+#define GOODIX_PACKED_SIZE(n_pixels)    ((n_pixels) / 4 * 6)
+
+/*
+ * Unpack the sensor's 12-bit pixel format (P14, doc 20 §15): every 6-byte
+ * chunk holds 4 pixels, laid out as in goodixtls5xx_decode_frame() and
+ * goodix-fp-dump:
+ *
+ *   p0 = (b0 & 0x0f) << 8 | b1       p2 = (b5 & 0x0f) << 8 | b2
+ *   p1 = b3 << 4 | b0 >> 4           p3 = b4 << 4 | b5 >> 4
+ *
+ * One pass, GOODIX_PACKED_SIZE(n_pixels) bytes in, n_pixels out; the
+ * buffers must not overlap.  Uses SSSE3 on x86-64 CPUs that have it.
+ * Returns 0, or −1 if n_pixels is not a positive multiple of 4.
+ */
+int goodix_decode_frame (const uint8_t *packed,
+                         int            n_pixels,
+                         uint16_t      *frame);
+
+/*
+ * frame:      scan_width × height raw pixels, modified in place (holds the
+ *             calibration-subtracted frame on return, as in the driver)
+ * cal:        calibration frame of the same size, or NULL to skip subtract
+ * out_width:  retained columns 0 … out_width−1 (left-aligned crop);
+ *             out_width == scan_width disables the crop
+ * boost:      unsharp boost; ≤ 0 skips the unsharp mask
+ * out:        out_width × height 8-bit result
+ *
+ * Returns 0, or −1 for unsupported dimensions.
+ */
+int goodix_preprocess_frame (uint16_t       *frame,
+                             const uint16_t *cal,
+                             int             scan_width,
+                             int             height,
+                             int             out_width,
+                             int             boost,
+                             uint8_t        *out);
+
+/*
+ * Calibration drift metric (P10, doc 20 §11): mean |raw − cal| over the
+ * guard columns guard_x0 … scan_width−1, which are cropped from the output
+ * and see little of the finger.  `raw` is the frame before subtraction.
+ * A uniform offset and a change in the fixed pattern both raise it; the
+ * driver compares it against the value recorded on the press that captured
+ * the cached air scan (read noise plus finger bleed).
+ */
+int goodix_cal_guard_drift (const uint16_t *raw,
+                            const uint16_t *cal,
+                            int             scan_width,
+                            int             height,
+                            int             guard_x0);
+
+#endif /* GOODIX_PREPROCESS_H */
@@ -0,0 +1,123 @@
+/*
+ * goodix-ring.c — Byte ring buffer for the goodixtls GnuTLS transport (P13, doc 20 §14)
+ *
+ * See goodix-ring.h.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "goodix-ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int
+goodix_ring_init(GoodixRing *r, size_t min_cap)
+{
+    size_t cap = 64;
+    while (cap < min_cap)
+        cap <<= 1;
+
+    r->data = malloc(cap);
+    r->cap = r->data ? cap : 0;
+    r->head = r->tail = 0;
+    return r->data ? 0 : -1;
+}
+
+void
+goodix_ring_free(GoodixRing *r)
+{
+    free(r->data);
+    r->data = NULL;
+    r->cap = r->head = r->tail = 0;
+}
+
+/* Grow to the next power of two that fits, copying the live bytes to the
+ * start of the new buffer. */
+int
+goodix_ring_reserve(GoodixRing *r, size_t n)
+{
+    size_t len = goodix_ring_len(r);
+    if (r->cap - len >= n)
+        return 0;
+
+    size_t cap = r->cap ? r->cap : 64;
+    while (cap - len < n)
+        cap <<= 1;
+
+    uint8_t *data = malloc(cap);
+    if (!data)
+        return -1;
+    size_t got = goodix_ring_pull(r, data, len);
+    free(r->data);
+    r->data = data;
+    r->cap = cap;
+    r->head = 0;
+    r->tail = got;
+    return 0;
+}
+
+int
+goodix_ring_push(GoodixRing *r, const void *src, size_t n)
+{
+    if (n == 0)
+        return 0;
+    if (goodix_ring_reserve(r, n) != 0)
+        return -1;
+
+    size_t off = r->tail & (r->cap - 1);
+    size_t first = r->cap - off < n ? r->cap - off : n;
+    memcpy(r->data + off, src, first);
+    memcpy(r->data, (const uint8_t *)src + first, n - first);
+    r->tail += n;
+    return 0;
+}
+
+size_t
+goodix_ring_pull(GoodixRing *r, void *dst, size_t n)
+{
+    size_t len = goodix_ring_len(r);
+    if (n > len)
+        n = len;
+    if (n == 0)
+        return 0;
+
+    size_t off = r->head & (r->cap - 1);
+    size_t first = r->cap - off < n ? r->cap - off : n;
+    memcpy(dst, r->data + off, first);
+    memcpy((uint8_t *)dst + first, r->data, n - first);
+    r->head += n;
+    return n;
+}
+
+size_t
+goodix_ring_read_span(const GoodixRing *r, const uint8_t **ptr)
+{
+    size_t off = r->head & (r->cap - 1);
+    size_t len = goodix_ring_len(r);
+    *ptr = r->data + off;
+    return r->cap - off < len ? r->cap - off : len;
+}
+
+void
+goodix_ring_consume(GoodixRing *r, size_t n)
+{
+    size_t len = goodix_ring_len(r);
+    r->head += n < len ? n : len;
+}
+
+size_t
+goodix_ring_write_span(GoodixRing *r, uint8_t **ptr)
+{
+    size_t off = r->tail & (r->cap - 1);
+    size_t free_bytes = r->cap - goodix_ring_len(r);
+    *ptr = r->data + off;
+    return r->cap - off < free_bytes ? r->cap - off : free_bytes;
+}
+
+void
+goodix_ring_commit(GoodixRing *r, size_t n)
+{
+    size_t free_bytes = r->cap - goodix_ring_len(r);
+    r->tail += n < free_bytes ? n : free_bytes;
+}
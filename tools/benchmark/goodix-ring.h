@@ -0,0 +1,66 @@
+/*
+ * goodix-ring.h — Byte ring buffer for the goodixtls GnuTLS transport (P13, doc 20 §14)
+ *
+ * Replaces the GByteArray in_buf/out_buf of gx_tls_push()/gx_tls_pull():
+ * consuming from the front never moves the remaining bytes.  Capacity is a
+ * power of two; head and tail are free-running counters masked on access,
+ * so full/empty need no extra flag.  The buffer grows (and linearises) only
+ * when a push does not fit, which after warm-up does not happen.
+ *
+ * Besides copy-in/copy-out there is a span API for zero-copy producers and
+ * consumers: goodix_ring_write_span() + goodix_ring_commit() let the USB
+ * receive path decode straight into the ring, goodix_ring_read_span() +
+ * goodix_ring_consume() let the reader parse in place.
+ *
+ * Not thread-safe; the driver uses it from the device's main context only.
+ * Plain C99 + stdint so the same file builds in the driver and in tools/.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef GOODIX_RING_H
+#define GOODIX_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t *data;
+    size_t   cap;       /* power of two */
+    size_t   head;      /* total bytes consumed */
+    size_t   tail;      /* total bytes committed */
+} GoodixRing;
+
+/* min_cap is rounded up to a power of two.  Returns 0, −1 on ENOMEM. */
+int    goodix_ring_init    (GoodixRing *r, size_t min_cap);
+void   goodix_ring_free    (GoodixRing *r);
+
+static inline size_t
+goodix_ring_len (const GoodixRing *r)
+{
+    return r->tail - r->head;
+}
+
+/* Make room for at least `n` more bytes; −1 on ENOMEM */
+int    goodix_ring_reserve (GoodixRing *r, size_t n);
+
+/* Copy `n` bytes in (growing if needed); −1 on ENOMEM */
+int    goodix_ring_push    (GoodixRing *r, const void *src, size_t n);
+
+/* Copy up to `n` bytes out and consume them; returns bytes copied */
+size_t goodix_ring_pull    (GoodixRing *r, void *dst, size_t n);
+
+/* Contiguous readable bytes at the head; *ptr is valid until the next
+ * push/reserve.  Fewer than goodix_ring_len() when the data wraps. */
+size_t goodix_ring_read_span  (const GoodixRing *r, const uint8_t **ptr);
+void   goodix_ring_consume    (GoodixRing *r, size_t n);
+
+/* Contiguous writable bytes at the tail; make written bytes visible with
+ * commit.  goodix_ring_reserve() guarantees total free space, not a
+ * contiguous tail: when the free space wraps the span may be shorter than
+ * what was reserved, and a caller needing n contiguous bytes must fall
+ * back to goodix_ring_push(). */
+size_t goodix_ring_write_span (GoodixRing *r, uint8_t **ptr);
+void   goodix_ring_commit     (GoodixRing *r, size_t n);
+
+#endif /* GOODIX_RING_H */
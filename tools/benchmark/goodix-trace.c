@@ -0,0 +1,85 @@
+/*
+ * goodix-trace.c — Per-operation stage timestamps for the scan SSM (P25, doc 20 §26)
+ *
+ * See goodix-trace.h.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include "goodix-trace.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *const stage_names[GOODIX_STAGE_COUNT] = {
+    [GOODIX_STAGE_FDT_ACK]     = "fdt",
+    [GOODIX_STAGE_CALIBRATION] = "cal",
+    [GOODIX_STAGE_XFER]        = "xfer",
+    [GOODIX_STAGE_DECRYPT]     = "decrypt",
+    [GOODIX_STAGE_PREPROCESS]  = "preprocess",
+    [GOODIX_STAGE_STDDEV_GATE] = "gate",
+    [GOODIX_STAGE_EXTRACT]     = "extract",
+    [GOODIX_STAGE_MATCH]       = "match",
+    [GOODIX_STAGE_RESULT]      = "result",
+};
+
+const char *
+goodix_stage_name(GoodixStage s)
+{
+    return (unsigned)s < GOODIX_STAGE_COUNT ? stage_names[s] : "?";
+}
+
+void
+goodix_trace_begin(GoodixTrace *t, const char *op, int64_t touch_us)
+{
+    t->n = 0;
+    t->t0_us = touch_us;
+    t->last_us = touch_us;
+    t->op = op;
+}
+
+void
+goodix_trace_span(GoodixTrace *t, GoodixStage s, int64_t start_us, int64_t end_us)
+{
+    GoodixTraceSpan *e = &t->ring[t->n % GOODIX_TRACE_RING];
+    e->start_us = start_us;
+    e->dur_us = end_us > start_us ? (int32_t)(end_us - start_us) : 0;
+    e->stage = (uint8_t)s;
+    t->n++;
+    if (end_us > t->last_us)
+        t->last_us = end_us;
+}
+
+/* snprintf that keeps counting once the buffer is full */
+static size_t
+append(char *buf, size_t len, size_t off, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int k = vsnprintf(off < len ? buf + off : NULL, off < len ? len - off : 0, fmt, ap);
+    va_end(ap);
+    return k < 0 ? off : off + (size_t)k;
+}
+
+size_t
+goodix_trace_format(const GoodixTrace *t, char *buf, size_t len)
+{
+    uint32_t kept = t->n < GOODIX_TRACE_RING ? t->n : GOODIX_TRACE_RING;
+    size_t off = 0;
+
+    if (len > 0)
+        buf[0] = '\0';
+    off = append(buf, len, off, "stages op=%s n=%" PRIu32 " dropped=%" PRIu32
+                 " total=%" PRId64, t->op ? t->op : "?", t->n, t->n - kept,
+                 t->last_us - t->t0_us);
+
+    for (uint32_t i = t->n - kept; i < t->n; i++) {
+        const GoodixTraceSpan *e = &t->ring[i % GOODIX_TRACE_RING];
+        off = append(buf, len, off, " %s=%" PRId64 "+%" PRId32,
+                     goodix_stage_name((GoodixStage)e->stage),
+                     e->start_us - t->t0_us, e->dur_us);
+    }
+    return off;
+}
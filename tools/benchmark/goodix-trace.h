@@ -0,0 +1,84 @@
+/*
+ * goodix-trace.h — Per-operation stage timestamps for the scan SSM (P25, doc 20 §26)
+ *
+ * Where the time between touch and result goes: the driver records one
+ * span per stage (finger-detect ack, calibration, image transfer, TLS
+ * decrypt, preprocess, stddev gate, extract, match, result report) into a
+ * fixed ring owned by the operation, and prints the whole ring as one
+ * debug line when the operation reports its result:
+ *
+ *   goodix trace: stages op=verify n=9 dropped=0 total=48210 fdt=0+412 cal=412+2650 ...
+ *
+ * Each entry is <stage>=<start>+<duration>, µs relative to the touch.
+ * Spans carry their own start, so stages that run on a worker while the
+ * SSM moves on (P8, P23) are recorded as they happened instead of being
+ * forced into sequence.  A retry or burst repeats stages; when an
+ * operation records more than GOODIX_TRACE_RING spans the oldest are
+ * overwritten and counted in `dropped`.
+ *
+ * Timestamps are passed in (the driver uses g_get_monotonic_time()), so
+ * the module reads no clock and allocates nothing.  Not thread-safe:
+ * workers return their start/end times with the job and the completion
+ * callback records them on the main context.  Plain C99 + stdint so the
+ * same file builds in the driver and in tools/.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef GOODIX_TRACE_H
+#define GOODIX_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    GOODIX_STAGE_FDT_ACK,       /* finger-down IRQ → detection acknowledged */
+    GOODIX_STAGE_CALIBRATION,   /* calibration sub-SSM (cached or captured) */
+    GOODIX_STAGE_XFER,          /* image request → last bulk-IN byte */
+    GOODIX_STAGE_DECRYPT,       /* TLS record → plaintext frame */
+    GOODIX_STAGE_PREPROCESS,    /* decode, subtract, squash, unsharp, crop */
+    GOODIX_STAGE_STDDEV_GATE,
+    GOODIX_STAGE_EXTRACT,       /* sigfm_extract() + keypoint gate */
+    GOODIX_STAGE_MATCH,         /* sub-template loop / gallery scan */
+    GOODIX_STAGE_RESULT,        /* report to fprintd */
+    GOODIX_STAGE_COUNT
+} GoodixStage;
+
+#define GOODIX_TRACE_RING   32
+
+typedef struct {
+    int64_t start_us;
+    int32_t dur_us;
+    uint8_t stage;
+} GoodixTraceSpan;
+
+typedef struct {
+    GoodixTraceSpan ring[GOODIX_TRACE_RING];
+    uint32_t        n;          /* spans recorded; the ring keeps the last RING */
+    int64_t         t0_us;      /* the touch */
+    int64_t         last_us;    /* end of the latest span, for mark() */
+    const char     *op;         /* "verify", "identify", "enroll" */
+} GoodixTrace;
+
+/* Short names used in the log line ("fdt", "cal", "xfer", ...) */
+const char *goodix_stage_name  (GoodixStage s);
+
+/* Start an operation at the touch */
+void        goodix_trace_begin (GoodixTrace *t, const char *op, int64_t touch_us);
+
+/* A stage that ran from start_us to end_us (any thread's clock reading) */
+void        goodix_trace_span  (GoodixTrace *t, GoodixStage s,
+                                int64_t start_us, int64_t end_us);
+
+/* A stage that started when the previous one ended: the common SSM case */
+static inline void
+goodix_trace_mark (GoodixTrace *t, GoodixStage s, int64_t now_us)
+{
+    goodix_trace_span (t, s, t->last_us, now_us);
+}
+
+/* The line after "goodix trace: ", snprintf-style: returns the length it
+ * needed, writes at most len bytes including the NUL. */
+size_t      goodix_trace_format (const GoodixTrace *t, char *buf, size_t len);
+
+#endif /* GOODIX_TRACE_H */
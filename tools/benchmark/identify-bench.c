@@ -0,0 +1,529 @@
+/*
+ * identify-bench.c — Native identify over a SIGFM gallery (P18, doc 20 §19)
+ *
+ * Each directory is one enrolled finger: its first E frames (sorted by
+ * name) are the print's sub-templates, the rest are genuine probes for it.
+ * Every probe is identified against the whole gallery three ways:
+ *
+ *   N verifies what fprintd gets from a verify-only driver: one verify per
+ *              print in gallery order, each with its own capture and
+ *              extraction and an exhaustive sub-template loop, until one
+ *              accepts
+ *   identify   one extraction, then every (print, sub-template) pair in
+ *              one loop, stopping at the first accept
+ *   parallel   the same work list on a pool of T workers; an accept stops
+ *              the others claiming work past it
+ *
+ * Both identify paths report the accept with the lowest work index, so
+ * they always name the same print: the pool finishes every item before
+ * its earliest accept, and a difference makes the tool exit 1.
+ *
+ * The work list is rank-major (sub-template 0 of every print, then 1, …) so
+ * that with a P17 order the likeliest entry of every print is tried first.
+ * Capture cost is not measured offline; --capture-ms adds it per verify.
+ *
+ * Usage:
+ *   identify-bench [--enroll=E] [--threshold=T] [--threads=N]
+ *                  [--capture-ms=C] finger1/ finger2/ ...
+ *
+ * Build:  see Makefile
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sigfm.h"
+#include "sigfm-defaults.h"
+
+/* ------------------------------------------------------------------ */
+/* Defaults                                                            */
+/* ------------------------------------------------------------------ */
+
+#define DEFAULT_ENROLL      20      /* nr_enroll_stages */
+#define DEFAULT_THRESHOLD   SIGFM_SCORE_THRESHOLD
+#define DEFAULT_THREADS     4
+#define MAX_PRINTS          64
+#define MAX_SUBTEMPLATES    64
+#define MAX_PROBES          4096
+#define MAX_THREADS         64
+
+/* ------------------------------------------------------------------ */
+/* PGM reader (binary P5) — same as sigfm-batch.c                      */
+/* ------------------------------------------------------------------ */
+
+static unsigned char *
+read_pgm(const char *path, int *out_w, int *out_h)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return NULL; }
+
+    char magic[3];
+    if (fscanf(f, "%2s", magic) != 1 || strcmp(magic, "P5") != 0) {
+        fprintf(stderr, "Not a binary PGM (P5): %s\n", path);
+        fclose(f); return NULL;
+    }
+
+    int c;
+    while ((c = fgetc(f)) == ' ' || c == '\t' || c == '\r' || c == '\n');
+    while (c == '#') {
+        while ((c = fgetc(f)) != '\n' && c != EOF);
+        while ((c = fgetc(f)) == ' ' || c == '\t' || c == '\r' || c == '\n');
+    }
+    ungetc(c, f);
+
+    int w, h, maxval;
+    if (fscanf(f, "%d %d %d", &w, &h, &maxval) != 3) {
+        fprintf(stderr, "Bad PGM header: %s\n", path);
+        fclose(f); return NULL;
+    }
+    fgetc(f); /* consume trailing whitespace */
+
+    if (maxval != 255) {
+        fprintf(stderr, "Unsupported bit depth (maxval=%d): %s\n", maxval, path);
+        fclose(f); return NULL;
+    }
+
+    unsigned char *buf = malloc((size_t)w * h);
+    if (!buf) { perror("malloc"); fclose(f); return NULL; }
+
+    if (fread(buf, 1, (size_t)w * h, f) != (size_t)w * h) {
+        fprintf(stderr, "Short read: %s\n", path);
+        free(buf); fclose(f); return NULL;
+    }
+
+    fclose(f);
+    *out_w = w;
+    *out_h = h;
+    return buf;
+}
+
+static double
+now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static int
+cmp_str(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Sorted *.pgm paths in dir; caller frees each and the array */
+static char **
+list_pgm(const char *dir, int *n_out)
+{
+    DIR *d = opendir(dir);
+    if (!d) { perror(dir); return NULL; }
+
+    char **paths = NULL;
+    int n = 0, cap = 0;
+    struct dirent *e;
+    while ((e = readdir(d))) {
+        size_t len = strlen(e->d_name);
+        if (len < 5 || strcmp(e->d_name + len - 4, ".pgm") != 0)
+            continue;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 64;
+            char **p = realloc(paths, (size_t)cap * sizeof(*paths));
+            if (!p) break;
+            paths = p;
+        }
+        size_t sz = strlen(dir) + len + 2;
+        paths[n] = malloc(sz);
+        if (!paths[n]) break;
+        snprintf(paths[n], sz, "%s/%s", dir, e->d_name);
+        n++;
+    }
+    closedir(d);
+    if (n > 1)
+        qsort(paths, (size_t)n, sizeof(*paths), cmp_str);
+    *n_out = n;
+    return paths;
+}
+
+/* ------------------------------------------------------------------ */
+/* Gallery                                                             */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    const char    *name;
+    SigfmImgInfo  *subs[MAX_SUBTEMPLATES];
+    int            n_subs;
+} Print;
+
+typedef struct {
+    unsigned char *pix;
+    int            w, h;
+    int            owner;       /* index of the print this finger enrolled */
+} Probe;
+
+typedef struct {
+    int print;                  /* -1 = no match */
+    int score;
+    int calls;
+} IdResult;
+
+/* Work item i of the rank-major list → (print, sub-template), or -1 when
+ * print has fewer sub-templates than the rank */
+static int
+work_item(const Print *prints, int n_prints, int i, int *sub)
+{
+    int p = i % n_prints;
+    *sub = i / n_prints;
+    return *sub < prints[p].n_subs ? p : -1;
+}
+
+/* ------------------------------------------------------------------ */
+/* N verifies and sequential identify                                 */
+/* ------------------------------------------------------------------ */
+
+static IdResult
+verify_each(const Print *prints, int n_prints, const Probe *pr, int threshold,
+            double capture_us, double *cost_us)
+{
+    IdResult r = { -1, -1, 0 };
+    *cost_us = 0;
+    for (int p = 0; p < n_prints; p++) {
+        /* Every verify captures and extracts its own probe */
+        double t0 = now_us();
+        SigfmImgInfo *info = sigfm_extract(pr->pix, pr->w, pr->h);
+        int best = -1;
+        for (int s = 0; info && s < prints[p].n_subs; s++) {
+            int score = sigfm_match_score(prints[p].subs[s], info);
+            r.calls++;
+            if (score > best) best = score;
+        }
+        if (info) sigfm_free_info(info);
+        *cost_us += capture_us + now_us() - t0;
+        if (best >= threshold) {
+            r.print = p;
+            r.score = best;
+            break;
+        }
+    }
+    return r;
+}
+
+static IdResult
+identify_seq(const Print *prints, int n_prints, int n_items, SigfmImgInfo *info,
+             int threshold)
+{
+    IdResult r = { -1, -1, 0 };
+    for (int i = 0; i < n_items; i++) {
+        int s, p = work_item(prints, n_prints, i, &s);
+        if (p < 0) continue;
+        int score = sigfm_match_score(prints[p].subs[s], info);
+        r.calls++;
+        if (score >= threshold) {
+            r.print = p;
+            r.score = score;
+            break;
+        }
+    }
+    return r;
+}
+
+/* ------------------------------------------------------------------ */
+/* Parallel identify — a fixed pool, as GThreadPool would be in the    */
+/* driver; two barriers per probe hand the job out and collect it      */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    const Print      *prints;
+    int               n_prints;
+    int               n_items;
+    int               threshold;
+    SigfmImgInfo     *info;         /* probe, shared read-only (P7) */
+    atomic_int        next;         /* next unclaimed work item */
+    atomic_int        stop;         /* lowest accepting item so far */
+    atomic_int        calls;
+    pthread_mutex_t   lock;
+    IdResult          result;       /* accept at `stop`, under lock */
+    int               quit;
+    pthread_barrier_t start, done;
+} Pool;
+
+static void *
+pool_worker(void *arg)
+{
+    Pool *pl = arg;
+    for (;;) {
+        pthread_barrier_wait(&pl->start);
+        if (pl->quit)
+            return NULL;
+        /* Items are claimed in order, so every item below the final
+         * `stop` has been matched: the same accept identify_seq() finds */
+        for (;;) {
+            int i = atomic_fetch_add_explicit(&pl->next, 1, memory_order_relaxed);
+            if (i >= atomic_load_explicit(&pl->stop, memory_order_relaxed))
+                break;
+            int s, p = work_item(pl->prints, pl->n_prints, i, &s);
+            if (p < 0) continue;
+            int score = sigfm_match_score(pl->prints[p].subs[s], pl->info);
+            atomic_fetch_add_explicit(&pl->calls, 1, memory_order_relaxed);
+            if (score >= pl->threshold) {
+                pthread_mutex_lock(&pl->lock);
+                if (i < atomic_load_explicit(&pl->stop, memory_order_relaxed)) {
+                    atomic_store_explicit(&pl->stop, i, memory_order_relaxed);
+                    pl->result.print = p;
+                    pl->result.score = score;
+                }
+                pthread_mutex_unlock(&pl->lock);
+            }
+        }
+        pthread_barrier_wait(&pl->done);
+    }
+}
+
+static IdResult
+identify_par(Pool *pl, SigfmImgInfo *info)
+{
+    pl->info = info;
+    atomic_store(&pl->next, 0);
+    atomic_store(&pl->stop, pl->n_items);
+    atomic_store(&pl->calls, 0);
+    pl->result = (IdResult){ -1, -1, 0 };
+    pthread_barrier_wait(&pl->start);
+    pthread_barrier_wait(&pl->done);
+    pl->result.calls = atomic_load(&pl->calls);
+    return pl->result;
+}
+
+/* ------------------------------------------------------------------ */
+/* Usage                                                               */
+/* ------------------------------------------------------------------ */
+
+static void
+usage(const char *argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [--enroll=E] [--threshold=T] [--threads=N] [--capture-ms=C]\n"
+        "          finger1/ finger2/ ...\n"
+        "\n"
+        "  --enroll=E      first E frames of each directory are the print (default: %d)\n"
+        "  --threshold=T   match score threshold (default: %d)\n"
+        "  --threads=N     workers for the parallel scan (default: %d, max %d)\n"
+        "  --capture-ms=C  capture cost added per verify in the N-verifies model\n"
+        "                  (default: 0)\n"
+        "\n"
+        "Each directory is one finger; its remaining frames are genuine probes.\n"
+        "Needs a reentrant sigfm.c (make -C tools reentrancy).\n",
+        argv0, DEFAULT_ENROLL, DEFAULT_THRESHOLD, DEFAULT_THREADS, MAX_THREADS);
+    exit(1);
+}
+
+/* ------------------------------------------------------------------ */
+/* Main                                                                */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    const char *label;
+    double      us;
+    long        calls;
+    int         correct, wrong, none;
+} Tally;
+
+static void
+tally(Tally *t, IdResult r, int owner, double us)
+{
+    t->us += us;
+    t->calls += r.calls;
+    if (r.print < 0)           t->none++;
+    else if (r.print == owner) t->correct++;
+    else                       t->wrong++;
+}
+
+int
+main(int argc, char *argv[])
+{
+    static Print prints[MAX_PRINTS];
+    static Probe probes[MAX_PROBES];
+    int n_prints = 0, n_probes = 0;
+    int enroll = DEFAULT_ENROLL;
+    int threshold = DEFAULT_THRESHOLD;
+    int threads = DEFAULT_THREADS;
+    double capture_ms = 0;
+    const char *dirs[MAX_PRINTS];
+    int n_dirs = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--enroll=", 9) == 0)
+            enroll = atoi(argv[i] + 9);
+        else if (strncmp(argv[i], "--threshold=", 12) == 0)
+            threshold = atoi(argv[i] + 12);
+        else if (strncmp(argv[i], "--threads=", 10) == 0)
+            threads = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "--capture-ms=", 13) == 0)
+            capture_ms = atof(argv[i] + 13);
+        else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+            usage(argv[0]);
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            usage(argv[0]);
+        } else if (n_dirs < MAX_PRINTS)
+            dirs[n_dirs++] = argv[i];
+        else {
+            fprintf(stderr, "Too many finger directories (max %d)\n", MAX_PRINTS);
+            return 1;
+        }
+    }
+    if (enroll < 1 || enroll > MAX_SUBTEMPLATES || threads < 1 || threads > MAX_THREADS)
+        usage(argv[0]);
+    if (n_dirs < 1) {
+        fprintf(stderr, "Need at least one finger directory\n");
+        usage(argv[0]);
+    }
+
+    /* ── Gallery + probes ──────────────────────────────────────── */
+
+    double extract_us = 0;
+    int extracts = 0;
+    for (int d = 0; d < n_dirs; d++) {
+        int n;
+        char **paths = list_pgm(dirs[d], &n);
+        if (!paths) continue;
+        Print *p = &prints[n_prints];
+        p->name = dirs[d];
+        int first_probe = n_probes;     /* committed once the print exists */
+        for (int i = 0; i < n; i++) {
+            int w, h;
+            unsigned char *pix = read_pgm(paths[i], &w, &h);
+            if (pix && p->n_subs < enroll) {
+                double t0 = now_us();
+                SigfmImgInfo *info = sigfm_extract(pix, w, h);
+                extract_us += now_us() - t0;
+                extracts++;
+                if (info)
+                    p->subs[p->n_subs++] = info;
+                free(pix);
+            } else if (pix && n_probes < MAX_PROBES) {
+                probes[n_probes++] = (Probe){ pix, w, h, n_prints };
+            } else {
+                free(pix);
+            }
+            free(paths[i]);
+        }
+        free(paths);
+        if (p->n_subs > 0) {
+            n_prints++;
+        } else {
+            if (n_probes > first_probe)
+                fprintf(stderr, "%s: no extractable enrollment frame, "
+                        "dropping %d probe(s)\n", dirs[d], n_probes - first_probe);
+            while (n_probes > first_probe)
+                free(probes[--n_probes].pix);
+        }
+    }
+    if (n_prints == 0 || n_probes == 0) {
+        fprintf(stderr, "Need enrolled frames and at least one probe\n");
+        return 1;
+    }
+
+    int max_subs = 0, total_subs = 0;
+    for (int p = 0; p < n_prints; p++) {
+        total_subs += prints[p].n_subs;
+        if (prints[p].n_subs > max_subs) max_subs = prints[p].n_subs;
+    }
+    int n_items = n_prints * max_subs;
+
+    printf("Gallery: %d prints, %d sub-templates; %d probes (threshold %d, %d threads)\n",
+           n_prints, total_subs, n_probes, threshold, threads);
+
+    /* ── Pool ──────────────────────────────────────────────────── */
+
+    Pool pool = {
+        .prints = prints, .n_prints = n_prints, .n_items = n_items,
+        .threshold = threshold,
+    };
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_barrier_init(&pool.start, NULL, (unsigned)threads + 1);
+    pthread_barrier_init(&pool.done, NULL, (unsigned)threads + 1);
+    pthread_t tids[MAX_THREADS];
+    for (int t = 0; t < threads; t++) {
+        if (pthread_create(&tids[t], NULL, pool_worker, &pool) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+
+    /* ── Runs ──────────────────────────────────────────────────── */
+
+    Tally tv = { .label = "N verifies" }, ts = { .label = "identify" },
+          tp = { .label = "parallel" };
+    int disagree = 0;
+
+    for (int q = 0; q < n_probes; q++) {
+        const Probe *pr = &probes[q];
+        double us;
+
+        IdResult rv = verify_each(prints, n_prints, pr, threshold,
+                                  capture_ms * 1000.0, &us);
+        tally(&tv, rv, pr->owner, us);
+
+        /* Both identify paths pay one capture and one extraction */
+        double t0 = now_us();
+        SigfmImgInfo *info = sigfm_extract(pr->pix, pr->w, pr->h);
+        double ext = now_us() - t0 + capture_ms * 1000.0;
+        extract_us += now_us() - t0;
+        extracts++;
+        if (!info) {
+            IdResult none = { -1, -1, 0 };
+            tally(&ts, none, pr->owner, ext);
+            tally(&tp, none, pr->owner, ext);
+            continue;
+        }
+
+        t0 = now_us();
+        IdResult rs = identify_seq(prints, n_prints, n_items, info, threshold);
+        tally(&ts, rs, pr->owner, ext + now_us() - t0);
+
+        t0 = now_us();
+        IdResult rp = identify_par(&pool, info);
+        tally(&tp, rp, pr->owner, ext + now_us() - t0);
+
+        if (rp.print != rs.print)
+            disagree++;
+        sigfm_free_info(info);
+    }
+
+    pool.quit = 1;
+    pthread_barrier_wait(&pool.start);
+    for (int t = 0; t < threads; t++)
+        pthread_join(tids[t], NULL);
+
+    /* ── Report ────────────────────────────────────────────────── */
+
+    printf("Extraction: %.0f us/frame\n\n", extract_us / extracts);
+    printf("%-10s  %10s  %12s  %8s  %6s  %6s\n",
+           "Path", "ms/probe", "calls/probe", "correct", "wrong", "none");
+    const Tally *all[] = { &tv, &ts, &tp };
+    for (int k = 0; k < 3; k++)
+        printf("%-10s  %10.2f  %12.1f  %8d  %6d  %6d\n", all[k]->label,
+               all[k]->us / 1000.0 / n_probes, (double)all[k]->calls / n_probes,
+               all[k]->correct, all[k]->wrong, all[k]->none);
+    if (tp.us > 0 && ts.us > 0)
+        printf("\nSpeed-up: identify %.1f× over N verifies, parallel %.1f× over identify\n",
+               tv.us / ts.us, ts.us / tp.us);
+    printf("Parallel/sequential disagreements: %d%s\n", disagree,
+           disagree ? " (FAIL: both report the lowest-index accept)" : "");
+
+    for (int p = 0; p < n_prints; p++)
+        for (int s = 0; s < prints[p].n_subs; s++)
+            sigfm_free_info(prints[p].subs[s]);
+    for (int q = 0; q < n_probes; q++)
+        free(probes[q].pix);
+    pthread_barrier_destroy(&pool.start);
+    pthread_barrier_destroy(&pool.done);
+    pthread_mutex_destroy(&pool.lock);
+    return disagree ? 1 : 0;
+}
@@ -0,0 +1,510 @@
+/*
+ * knn-bench.c — Per-match KNN kernels for sigfm_match_score() (P4/P5, doc 20 §5–6)
+ *
+ * Benchmarks the brute-force 2-NN stage of sigfm_match_score() (128 × 128
+ * BRIEF-256 Hamming distances + ratio test) against exact alternatives:
+ *
+ *   full       every pair gets the full 256-bit distance (current sigfm.c)
+ *   prefix     64-bit prefix filter: the distance over the 64 most
+ *              discriminative bits is a lower bound on the full distance,
+ *              so a pair whose prefix distance already reaches the current
+ *              second-best cannot enter the top-2 and is skipped
+ *   progress   the same bound applied after every 64-bit word
+ *
+ * Bits are ranked offline on training pairs (genuine mutual nearest
+ * neighbours vs random pairs) and descriptors are stored bit-permuted so the
+ * top 64 sit in word 0.  Permuting both sides identically leaves every
+ * distance unchanged, so the driver can keep descriptors in that order.
+ *
+ * The ratio test and the mutual-best cross-check need neighbours in both
+ * directions.  For that the tool also compares:
+ *
+ *   two-pass   forward and reverse full scans, 2 × 128 × 128 distances
+ *   matrix     one 128 × 128 uint16 distance matrix, filled in L1-sized
+ *              tiles, then a single row-major sweep that derives forward
+ *              top-2, reverse top-2 and mutual best with branchless
+ *              min/max on packed (distance, index) keys
+ *
+ * Every kernel's neighbours are checked against `full` / `two-pass`; any
+ * mismatch makes the tool exit non-zero.
+ *
+ * Usage:
+ *   knn-bench [--pairs=N] [--reps=N]
+ *   knn-bench desc_0001.bin desc_0002.bin ...   (consecutive frames paired)
+ *
+ * Build:  see Makefile
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "brief-desc.h"
+
+/* ================================================================== */
+/* Parameters                                                          */
+/* ================================================================== */
+
+#define DEFAULT_PAIRS       200     /* genuine frame pairs to match */
+#define DEFAULT_REPS        20      /* timing repetitions per pair */
+#define TRAIN_FINGERS       40      /* synthetic fingers for bit ranking */
+#define RATIO_TEST          0.80f   /* sigfm.c RATIO_TEST */
+#define BITS                (BRIEF_BYTES * 8)
+#define TILE                32      /* 32×32 tile: 2 KB of distances + 2 KB of descriptors */
+
+/* Per-descriptor 2-NN result */
+typedef struct {
+    int i1, d1, i2, d2;
+} Knn2;
+
+/* ================================================================== */
+/* Bit ranking                                                         */
+/* ================================================================== */
+
+/* Score each bit by P(differ | random pair) − P(differ | genuine pair).
+ * Genuine pairs are mutual nearest neighbours between two frames of one
+ * finger that also pass the ratio test. */
+static void
+rank_bits(const BriefSet *frames, int n_pairs, int *order)
+{
+    static double score[BITS];
+    long gen_diff[BITS] = { 0 }, rnd_diff[BITS] = { 0 };
+    long n_gen = 0, n_rnd = 0;
+    uint64_t rng = 0xB175ULL;
+
+    for (int p = 0; p < n_pairs; p++) {
+        const BriefSet *a = &frames[2 * p], *b = &frames[2 * p + 1];
+        for (int i = 0; i < a->n; i++) {
+            int j1 = -1, d1 = 1 << 30, d2 = 1 << 30;
+            for (int j = 0; j < b->n; j++) {
+                int d = brief_hamming(&a->d[i], &b->d[j]);
+                if (d < d1) { d2 = d1; d1 = d; j1 = j; }
+                else if (d < d2) d2 = d;
+            }
+            if (j1 < 0 || (float)d1 >= RATIO_TEST * (float)d2)
+                continue;
+
+            int back = -1, bd = 1 << 30;
+            for (int k = 0; k < a->n; k++) {
+                int d = brief_hamming(&a->d[k], &b->d[j1]);
+                if (d < bd) { bd = d; back = k; }
+            }
+            if (back != i)
+                continue;
+
+            const BriefDesc *r = &b->d[brief_rng_next(&rng) % (uint64_t)b->n];
+            for (int bit = 0; bit < BITS; bit++) {
+                gen_diff[bit] += brief_bit(&a->d[i], bit) != brief_bit(&b->d[j1], bit);
+                rnd_diff[bit] += brief_bit(&a->d[i], bit) != brief_bit(r, bit);
+            }
+            n_gen++;
+            n_rnd++;
+        }
+    }
+
+    for (int bit = 0; bit < BITS; bit++) {
+        score[bit] = n_gen ? (double)rnd_diff[bit] / n_rnd - (double)gen_diff[bit] / n_gen : 0;
+        order[bit] = bit;
+    }
+    /* Insertion sort, descending score; 256 entries */
+    for (int i = 1; i < BITS; i++) {
+        int v = order[i], j = i - 1;
+        while (j >= 0 && score[order[j]] < score[v]) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = v;
+    }
+    double top = 0, bottom = 0;
+    for (int i = 0; i < 64; i++) {
+        top += score[order[i]];
+        bottom += score[order[BITS - 1 - i]];
+    }
+    printf("Bit ranking: %ld genuine pairs, mean score top-64 %.3f, "
+           "bottom-64 %.3f\n", n_gen, top / 64, bottom / 64);
+}
+
+/* out bit i = in bit order[i] */
+static void
+permute_set(const BriefSet *in, const int *order, BriefSet *out)
+{
+    out->n = in->n;
+    for (int k = 0; k < in->n; k++) {
+        BriefDesc d = { { 0, 0, 0, 0 } };
+        for (int i = 0; i < BITS; i++)
+            if (brief_bit(&in->d[k], order[i]))
+                d.w[i >> 6] |= 1ULL << (i & 63);
+        out->d[k] = d;
+    }
+}
+
+/* ================================================================== */
+/* KNN kernels                                                         */
+/* ================================================================== */
+
+/* All three return the same neighbours as a linear scan with strict
+ * improvement, i.e. ties resolved to the lowest index. */
+
+static void
+knn2_full(const BriefSet *a, const BriefSet *b, Knn2 *out, long *full_dists)
+{
+    for (int i = 0; i < a->n; i++) {
+        int j1 = -1, j2 = -1, d1 = 1 << 30, d2 = 1 << 30;
+        for (int j = 0; j < b->n; j++) {
+            int d = brief_hamming(&a->d[i], &b->d[j]);
+            if (d < d1) { j2 = j1; d2 = d1; j1 = j; d1 = d; }
+            else if (d < d2) { j2 = j; d2 = d; }
+        }
+        out[i] = (Knn2){ j1, d1, j2, d2 };
+    }
+    *full_dists += (long)a->n * b->n;
+}
+
+static void
+knn2_prefix(const BriefSet *a, const BriefSet *b, Knn2 *out, long *full_dists)
+{
+    long full = 0;
+    for (int i = 0; i < a->n; i++) {
+        const BriefDesc *q = &a->d[i];
+        int j1 = -1, j2 = -1, d1 = 1 << 30, d2 = 1 << 30;
+        for (int j = 0; j < b->n; j++) {
+            const BriefDesc *c = &b->d[j];
+            int d = __builtin_popcountll(q->w[0] ^ c->w[0]);
+            if (d >= d2)
+                continue;
+            d += __builtin_popcountll(q->w[1] ^ c->w[1]) +
+                 __builtin_popcountll(q->w[2] ^ c->w[2]) +
+                 __builtin_popcountll(q->w[3] ^ c->w[3]);
+            full++;
+            if (d < d1) { j2 = j1; d2 = d1; j1 = j; d1 = d; }
+            else if (d < d2) { j2 = j; d2 = d; }
+        }
+        out[i] = (Knn2){ j1, d1, j2, d2 };
+    }
+    *full_dists += full;
+}
+
+static void
+knn2_progress(const BriefSet *a, const BriefSet *b, Knn2 *out, long *full_dists)
+{
+    long full = 0;
+    for (int i = 0; i < a->n; i++) {
+        const BriefDesc *q = &a->d[i];
+        int j1 = -1, j2 = -1, d1 = 1 << 30, d2 = 1 << 30;
+        for (int j = 0; j < b->n; j++) {
+            const BriefDesc *c = &b->d[j];
+            int d = __builtin_popcountll(q->w[0] ^ c->w[0]);
+            if (d >= d2) continue;
+            d += __builtin_popcountll(q->w[1] ^ c->w[1]);
+            if (d >= d2) continue;
+            d += __builtin_popcountll(q->w[2] ^ c->w[2]);
+            if (d >= d2) continue;
+            d += __builtin_popcountll(q->w[3] ^ c->w[3]);
+            full++;
+            if (d < d1) { j2 = j1; d2 = d1; j1 = j; d1 = d; }
+            else if (d < d2) { j2 = j; d2 = d; }
+        }
+        out[i] = (Knn2){ j1, d1, j2, d2 };
+    }
+    *full_dists += full;
+}
+
+/* ================================================================== */
+/* Bidirectional kernels: forward, reverse and mutual best             */
+/* ================================================================== */
+
+typedef struct {
+    Knn2 fwd[BRIEF_MAX_KP];     /* a[i] → nearest two in b */
+    Knn2 rev[BRIEF_MAX_KP];     /* b[j] → nearest two in a */
+    int  mutual[BRIEF_MAX_KP];  /* j if a[i] and b[j] are each other's best, else −1 */
+} KnnBoth;
+
+static void
+mutual_from(const BriefSet *a, KnnBoth *out)
+{
+    for (int i = 0; i < a->n; i++) {
+        int j = out->fwd[i].i1;
+        out->mutual[i] = (j >= 0 && out->rev[j].i1 == i) ? j : -1;
+    }
+}
+
+static void
+both_two_pass(const BriefSet *a, const BriefSet *b, KnnBoth *out)
+{
+    long dummy = 0;
+    knn2_full(a, b, out->fwd, &dummy);
+    knn2_full(b, a, out->rev, &dummy);
+    mutual_from(a, out);
+}
+
+/* Top-2 on packed keys (distance << 8 | index): ordering by key is
+ * ordering by distance with ties to the lowest index, and the update is
+ * branchless min/max, so the column sweep vectorises. */
+#define KEY(d, idx)     ((uint32_t)(d) << 8 | (uint32_t)(idx))
+#define KEY_NONE        UINT32_MAX
+#define DIST_PAD        0xFFFF  /* columns ≥ b->n: never beats a real distance */
+
+static inline void
+top2_update(uint32_t *m1, uint32_t *m2, uint32_t k)
+{
+    uint32_t hi = k > *m1 ? k : *m1;
+    *m2 = hi < *m2 ? hi : *m2;
+    *m1 = k < *m1 ? k : *m1;
+}
+
+static inline Knn2
+top2_unpack(uint32_t m1, uint32_t m2)
+{
+    Knn2 k = { -1, 1 << 30, -1, 1 << 30 };
+    if ((m1 >> 8) < DIST_PAD) { k.i1 = (int)(m1 & 0xFF); k.d1 = (int)(m1 >> 8); }
+    if ((m2 >> 8) < DIST_PAD) { k.i2 = (int)(m2 & 0xFF); k.d2 = (int)(m2 >> 8); }
+    return k;
+}
+
+/* Fill D tile by tile so the working set (two descriptor tiles + one
+ * distance tile) stays in L1, then sweep D once in row-major order: row i
+ * reduces to fwd[i], and every column j folds into rev[j].  Rows are padded
+ * to BRIEF_MAX_KP columns so the sweep has a constant trip count, which is
+ * what lets GCC vectorise it at plain -O2. */
+static void
+both_matrix(const BriefSet *a, const BriefSet *b, KnnBoth *out)
+{
+    uint16_t D[BRIEF_MAX_KP * BRIEF_MAX_KP];
+    uint32_t r1[BRIEF_MAX_KP], r2[BRIEF_MAX_KP];
+    const int na = a->n, nb = b->n;
+
+    for (int i = 0; i < na; i++)
+        for (int j = nb; j < BRIEF_MAX_KP; j++)
+            D[i * BRIEF_MAX_KP + j] = DIST_PAD;
+
+    for (int ib = 0; ib < na; ib += TILE) {
+        int ie = ib + TILE < na ? ib + TILE : na;
+        for (int jb = 0; jb < nb; jb += TILE) {
+            int je = jb + TILE < nb ? jb + TILE : nb;
+            for (int i = ib; i < ie; i++) {
+                uint16_t *row = &D[i * BRIEF_MAX_KP];
+                for (int j = jb; j < je; j++)
+                    row[j] = (uint16_t)brief_hamming(&a->d[i], &b->d[j]);
+            }
+        }
+    }
+
+    for (int j = 0; j < BRIEF_MAX_KP; j++)
+        r1[j] = r2[j] = KEY_NONE;
+
+    for (int i = 0; i < na; i++) {
+        const uint16_t *row = &D[i * BRIEF_MAX_KP];
+        uint32_t f1 = KEY_NONE, f2 = KEY_NONE;
+        for (int j = 0; j < BRIEF_MAX_KP; j++)
+            top2_update(&f1, &f2, KEY(row[j], j));
+        for (int j = 0; j < BRIEF_MAX_KP; j++)
+            top2_update(&r1[j], &r2[j], KEY(row[j], i));
+        out->fwd[i] = top2_unpack(f1, f2);
+    }
+    for (int j = 0; j < nb; j++)
+        out->rev[j] = top2_unpack(r1[j], r2[j]);
+    mutual_from(a, out);
+}
+
+/* ================================================================== */
+/* Benchmark                                                           */
+/* ================================================================== */
+
+typedef void (*KnnFn)(const BriefSet *, const BriefSet *, Knn2 *, long *);
+
+typedef struct {
+    const char *name;
+    KnnFn       fn;
+} Kernel;
+
+static const Kernel kernels[] = {
+    { "full",     knn2_full },
+    { "prefix",   knn2_prefix },
+    { "progress", knn2_progress },
+};
+#define N_KERNELS (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+/* Returns the number of neighbour lists that differ from `full` */
+static int
+run_bench(const BriefSet *frames, int n_pairs, int reps)
+{
+    static Knn2 ref[BRIEF_MAX_KP], got[BRIEF_MAX_KP];
+    int mismatches = 0;
+
+    printf("\n%-10s  %12s  %14s  %10s\n", "kernel", "us/match", "full dists", "avoided");
+    for (int k = 0; k < N_KERNELS; k++) {
+        long full = 0, total = 0;
+        for (int p = 0; p < n_pairs; p++) {
+            const BriefSet *a = &frames[2 * p], *b = &frames[2 * p + 1];
+            long dummy = 0;
+            knn2_full(a, b, ref, &dummy);
+            kernels[k].fn(a, b, got, &full);
+            total += (long)a->n * b->n;
+            if (memcmp(ref, got, (size_t)a->n * sizeof(Knn2)) != 0)
+                mismatches++;
+        }
+
+        long sink = 0;
+        double t0 = brief_now_us();
+        for (int r = 0; r < reps; r++)
+            for (int p = 0; p < n_pairs; p++) {
+                kernels[k].fn(&frames[2 * p], &frames[2 * p + 1], got, &sink);
+                sink += got[0].d1;
+            }
+        double us = (brief_now_us() - t0) / ((double)reps * n_pairs);
+
+        printf("%-10s  %12.2f  %13.1f%%  %9.1f%%\n", kernels[k].name, us,
+               100.0 * full / total, 100.0 * (total - full) / total);
+    }
+    return mismatches;
+}
+
+typedef void (*BothFn)(const BriefSet *, const BriefSet *, KnnBoth *);
+
+static const struct {
+    const char *name;
+    BothFn      fn;
+    int         passes;     /* a->n × b->n distance sweeps per pair */
+} both_kernels[] = {
+    { "two-pass", both_two_pass, 2 },
+    { "matrix",   both_matrix,   1 },
+};
+#define N_BOTH (int)(sizeof(both_kernels) / sizeof(both_kernels[0]))
+
+/* Forward + reverse + mutual best.  Returns mismatches vs two-pass. */
+static int
+run_bench_both(const BriefSet *frames, int n_pairs, int reps)
+{
+    static KnnBoth ref, got;
+    int mismatches = 0;
+
+    printf("\n%-10s  %12s  %14s  %10s\n", "both-dir", "us/match", "dists/pair", "mutual");
+    for (int k = 0; k < N_BOTH; k++) {
+        long n_mutual = 0, n_rows = 0, dists = 0;
+        for (int p = 0; p < n_pairs; p++) {
+            const BriefSet *a = &frames[2 * p], *b = &frames[2 * p + 1];
+            both_two_pass(a, b, &ref);
+            both_kernels[k].fn(a, b, &got);
+            if (memcmp(ref.fwd, got.fwd, (size_t)a->n * sizeof(Knn2)) != 0 ||
+                memcmp(ref.rev, got.rev, (size_t)b->n * sizeof(Knn2)) != 0 ||
+                memcmp(ref.mutual, got.mutual, (size_t)a->n * sizeof(int)) != 0)
+                mismatches++;
+            for (int i = 0; i < a->n; i++)
+                n_mutual += got.mutual[i] >= 0;
+            n_rows += a->n;
+            dists += (long)both_kernels[k].passes * a->n * b->n;
+        }
+
+        double t0 = brief_now_us();
+        for (int r = 0; r < reps; r++)
+            for (int p = 0; p < n_pairs; p++)
+                both_kernels[k].fn(&frames[2 * p], &frames[2 * p + 1], &got);
+        double us = (brief_now_us() - t0) / ((double)reps * n_pairs);
+
+        printf("%-10s  %12.2f  %14.0f  %9.1f%%\n", both_kernels[k].name, us,
+               (double)dists / n_pairs, 100.0 * n_mutual / n_rows);
+    }
+    return mismatches;
+}
+
+/* ================================================================== */
+/* Usage                                                               */
+/* ================================================================== */
+
+static void
+usage(const char *argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [--pairs=N] [--reps=N] [desc_0001.bin desc_0002.bin ...]\n"
+        "\n"
+        "  --pairs=N   synthetic genuine frame pairs (default: %d)\n"
+        "  --reps=N    timing repetitions (default: %d)\n"
+        "\n"
+        "With descriptor dumps, consecutive files form a pair and the bit\n"
+        "ranking is trained on the same pairs (optimistic).\n",
+        argv0, DEFAULT_PAIRS, DEFAULT_REPS);
+    exit(1);
+}
+
+/* ================================================================== */
+/* Main                                                                */
+/* ================================================================== */
+
+int
+main(int argc, char *argv[])
+{
+    const char *files[4096];
+    int n_files = 0;
+    int pairs = DEFAULT_PAIRS;
+    int reps = DEFAULT_REPS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--pairs=", 8) == 0)
+            pairs = atoi(argv[i] + 8);
+        else if (strncmp(argv[i], "--reps=", 7) == 0)
+            reps = atoi(argv[i] + 7);
+        else if (argv[i][0] == '-')
+            usage(argv[0]);
+        else if (n_files < 4096)
+            files[n_files++] = argv[i];
+    }
+    if (pairs < 1 || reps < 1)
+        usage(argv[0]);
+
+    BriefSet *frames, *train;
+    int n_train;
+
+    if (n_files) {
+        pairs = n_files / 2;
+        if (pairs < 1) usage(argv[0]);
+        frames = malloc((size_t)pairs * 2 * sizeof(BriefSet));
+        if (!frames) { perror("malloc"); return 1; }
+        for (int i = 0; i < pairs * 2; i++)
+            if (brief_set_read(files[i], &frames[i]) < 0) {
+                free(frames);
+                return 1;
+            }
+        train = frames;
+        n_train = pairs;
+    } else {
+        frames = malloc((size_t)pairs * 2 * sizeof(BriefSet));
+        train = malloc((size_t)TRAIN_FINGERS * 2 * sizeof(BriefSet));
+        if (!frames || !train) { perror("malloc"); return 1; }
+
+        uint64_t rng = 0xC0FFEEULL;
+        for (int p = 0; p < pairs; p++) {
+            SynthFinger sf;
+            synth_finger_init(&sf, 5000 + (uint64_t)p);
+            synth_capture(&sf, &frames[2 * p], &rng);
+            synth_capture(&sf, &frames[2 * p + 1], &rng);
+        }
+        for (int p = 0; p < TRAIN_FINGERS; p++) {
+            SynthFinger sf;
+            synth_finger_init(&sf, 9000 + (uint64_t)p);
+            synth_capture(&sf, &train[2 * p], &rng);
+            synth_capture(&sf, &train[2 * p + 1], &rng);
+        }
+        n_train = TRAIN_FINGERS;
+    }
+
+    int order[BITS];
+    rank_bits(train, n_train, order);
+    for (int i = 0; i < pairs * 2; i++) {
+        BriefSet tmp;
+        permute_set(&frames[i], order, &tmp);
+        frames[i] = tmp;
+    }
+
+    printf("%d frame pairs%s, %d reps\n", pairs, n_files ? "" : " (synthetic)", reps);
+    int mismatches = run_bench(frames, pairs, reps);
+    mismatches += run_bench_both(frames, pairs, reps);
+
+    printf("\nExactness: %s (%d frame pairs differ from full search)\n",
+           mismatches ? "FAIL" : "OK", mismatches);
+
+    if (train != frames) free(train);
+    free(frames);
+    return mismatches ? 1 : 0;
+}
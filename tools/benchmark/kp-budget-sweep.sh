@@ -0,0 +1,106 @@
+#!/usr/bin/env bash
+#
+# kp-budget-sweep.sh — Match time vs keypoint budget vs FRR/FAR (P6, doc 20 §7)
+#
+# Runs sigfm-batch with --kp-budget=N for each budget: every finger of the
+# enroll corpus against the same finger (genuine) and every other finger
+# (impostor) of the verify corpus.  Reports aggregate FRR, FAR and the
+# mean per-frame extraction and per-call match time.
+#
+# Needs sigfm-batch built against a sigfm.h that provides
+# sigfm_extract_budget() (SIGFM_HAVE_KP_BUDGET).
+#
+# Usage:
+#   ./tools/benchmark/kp-budget-sweep.sh <s1_corpus> <s2_corpus> [budgets...]
+#
+# Examples:
+#   ./tools/benchmark/kp-budget-sweep.sh corpus/5finger corpus/5finger-s2
+#   ./tools/benchmark/kp-budget-sweep.sh corpus/5finger corpus/5finger-s2 48 64 96 128
+#
+# SPDX-License-Identifier: LGPL-2.1-or-later
+
+set -euo pipefail
+
+S1_DIR="${1:?Usage: $0 <s1_corpus> <s2_corpus> [budgets...]}"
+S2_DIR="${2:?Usage: $0 <s1_corpus> <s2_corpus> [budgets...]}"
+shift 2
+BUDGETS=("$@")
+[[ ${#BUDGETS[@]} -eq 0 ]] && BUDGETS=(32 48 64 96 128)
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+BATCH="$SCRIPT_DIR/sigfm-batch"
+ST=7        # Phase 12 operating point (doc 20 §1)
+
+if [[ ! -x "$BATCH" ]]; then
+    echo "sigfm-batch not found — run: make -C tools" >&2
+    exit 1
+fi
+
+FINGERS=()
+for d in "$S1_DIR"/*/; do
+    [[ -d "$d" && -d "$S2_DIR/$(basename "$d")" ]] && FINGERS+=("$(basename "$d")")
+done
+if [[ ${#FINGERS[@]} -eq 0 ]]; then
+    echo "ERROR: no finger subdirectories common to $S1_DIR and $S2_DIR" >&2
+    exit 1
+fi
+
+echo "══════════════════════════════════════════════════════════════"
+echo "  Keypoint Budget Sweep"
+echo "══════════════════════════════════════════════════════════════"
+echo "  S1 (enroll):  $S1_DIR"
+echo "  S2 (verify):  $S2_DIR"
+echo "  Fingers:      ${FINGERS[*]}"
+echo "  Threshold:    $ST"
+echo "  Budgets:      ${BUDGETS[*]}"
+echo "──────────────────────────────────────────────────────────────"
+printf "  %-7s  %7s  %7s  %12s  %12s\n" "budget" "FRR" "FAR" "extract us" "match us"
+
+# Prints: MATCHES REJECTIONS EXTRACT_US MATCH_US
+run_batch() {
+    local output
+    output=$("$BATCH" "$@" --score-threshold=$ST 2>&1) || true
+    if grep -q "needs a sigfm.h" <<< "$output"; then
+        echo "ERROR: sigfm-batch was built without keypoint budget support" >&2
+        exit 1
+    fi
+    local m f e t
+    m=$(grep -oP 'Matches:\s+\K\d+' <<< "$output" || echo 0)
+    f=$(grep -oP 'Rejections:\s+\K\d+' <<< "$output" || echo 0)
+    e=$(grep -oP 'extract \K[\d.]+' <<< "$output" || echo 0)
+    t=$(grep -oP 'match \K[\d.]+(?= us/call)' <<< "$output" || echo 0)
+    echo "$m $f $e $t"
+}
+
+for budget in "${BUDGETS[@]}"; do
+    g_m=0; g_f=0; i_m=0; i_f=0
+    sum_e=0; sum_t=0; runs=0
+
+    for finger in "${FINGERS[@]}"; do
+        mapfile -t enroll_args < <(ls "$S1_DIR/$finger"/capture_*.pgm | sort)
+        mapfile -t verify_args < <(ls "$S2_DIR/$finger"/capture_*.pgm | sort)
+
+        read -r m f e t < <(run_batch --enroll "${enroll_args[@]}" \
+            --verify "${verify_args[@]}" --kp-budget="$budget")
+        g_m=$((g_m + m)); g_f=$((g_f + f))
+        sum_e=$(awk "BEGIN{print $sum_e + $e}")
+        sum_t=$(awk "BEGIN{print $sum_t + $t}")
+        runs=$((runs + 1))
+
+        for other in "${FINGERS[@]}"; do
+            [[ "$other" == "$finger" ]] && continue
+            mapfile -t imp_args < <(ls "$S2_DIR/$other"/capture_*.pgm | sort)
+            read -r m f e t < <(run_batch --enroll "${enroll_args[@]}" \
+                --verify "${imp_args[@]}" --kp-budget="$budget")
+            i_m=$((i_m + m)); i_f=$((i_f + f))
+        done
+    done
+
+    frr=$(awk "BEGIN{t=$g_m+$g_f; printf \"%.1f\", t ? $g_f/t*100 : 0}")
+    far=$(awk "BEGIN{t=$i_m+$i_f; printf \"%.2f\", t ? $i_m/t*100 : 0}")
+    ext=$(awk "BEGIN{printf \"%.0f\", $sum_e/$runs}")
+    mt=$(awk "BEGIN{printf \"%.0f\", $sum_t/$runs}")
+    printf "  %-7s  %6s%%  %6s%%  %12s  %12s\n" "$budget" "$frr" "$far" "$ext" "$mt"
+done
+
+echo "══════════════════════════════════════════════════════════════"
@@ -0,0 +1,287 @@
+/*
+ * mih-bench.c — Multi-index hashing vs brute force over BRIEF-256 (P3)
+ *
+ * Builds galleries of synthetic BRIEF-256 descriptors (brief-desc.h finger
+ * model) of increasing size, indexes each with brief-mih.h, and compares
+ * per-query latency of:
+ *
+ *   brute      linear popcount scan over the whole gallery
+ *   mih        multi-index hashing, 8-bit and 16-bit substrings
+ *
+ * for two query types:
+ *
+ *   2-NN       exact nearest + second nearest (what the ratio test needs)
+ *   r-NN       every descriptor within Hamming radius r
+ *
+ * Every MIH answer is checked against brute force; any mismatch is counted
+ * and makes the tool exit non-zero, so the run doubles as the exactness test.
+ *
+ * Usage:
+ *   mih-bench [--sizes=128,1024,8192,65536,524288] [--queries=N]
+ *             [--radius=R] [--sub-bits=8|16|0]
+ *
+ * Build:  see Makefile
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "brief-desc.h"
+#include "brief-mih.h"
+
+/* ================================================================== */
+/* Parameters                                                          */
+/* ================================================================== */
+
+#define DEFAULT_QUERIES     256
+#define DEFAULT_RADIUS      40
+#define MAX_SIZE_STEPS      16
+#define MAX_RADIUS_OUT      4096
+
+/* ================================================================== */
+/* Brute-force reference                                               */
+/* ================================================================== */
+
+/* Lowest id wins ties, matching brief_mih_knn2() */
+static void
+brute_knn2(const BriefDesc *db, int n, const BriefDesc *q,
+           int *i1, int *d1, int *i2, int *d2)
+{
+    int b1 = -1, b2 = -1, bd1 = 1 << 30, bd2 = 1 << 30;
+    for (int i = 0; i < n; i++) {
+        int d = brief_hamming(q, &db[i]);
+        if (d < bd1) {
+            b2 = b1; bd2 = bd1;
+            b1 = i; bd1 = d;
+        } else if (d < bd2) {
+            b2 = i; bd2 = d;
+        }
+    }
+    *i1 = b1; *d1 = bd1;
+    *i2 = b2; *d2 = bd2;
+}
+
+static int
+brute_radius(const BriefDesc *db, int n, const BriefDesc *q, int r)
+{
+    int found = 0;
+    for (int i = 0; i < n; i++)
+        if (brief_hamming(q, &db[i]) <= r)
+            found++;
+    return found;
+}
+
+/* ================================================================== */
+/* Gallery                                                             */
+/* ================================================================== */
+
+/* n descriptors from consecutive captures of synthetic fingers, 20
+ * captures per finger like an enrolled print.  Queries are fresh captures
+ * of fingers in the gallery, so each has genuine near neighbours. */
+static void
+build_gallery(BriefDesc *db, int n, BriefDesc *queries, int n_queries)
+{
+    uint64_t rng = 0x3141592653ULL;
+    int fingers = (n + 20 * BRIEF_MAX_KP - 1) / (20 * BRIEF_MAX_KP);
+    int filled = 0;
+
+    for (int f = 0; f < fingers && filled < n; f++) {
+        SynthFinger sf;
+        synth_finger_init(&sf, (uint64_t)f + 1000);
+        for (int c = 0; c < 20 && filled < n; c++) {
+            BriefSet s;
+            synth_capture(&sf, &s, &rng);
+            for (int i = 0; i < s.n && filled < n; i++)
+                db[filled++] = s.d[i];
+        }
+    }
+
+    for (int q = 0; q < n_queries; ) {
+        SynthFinger sf;
+        synth_finger_init(&sf, 1000 + brief_rng_next(&rng) % (uint64_t)fingers);
+        BriefSet s;
+        synth_capture(&sf, &s, &rng);
+        for (int i = 0; i < s.n && q < n_queries; i++)
+            queries[q++] = s.d[i];
+    }
+}
+
+/* ================================================================== */
+/* Benchmark                                                           */
+/* ================================================================== */
+
+static int
+parse_int_list(const char *s, int *out, int max)
+{
+    int n = 0;
+    while (*s && n < max) {
+        out[n++] = atoi(s);
+        const char *comma = strchr(s, ',');
+        if (!comma) break;
+        s = comma + 1;
+    }
+    return n;
+}
+
+/* Returns the number of answers that differ from brute force */
+static int
+bench_size(int n, int n_queries, int radius, const int *sub_bits, int n_sub)
+{
+    BriefDesc *db = malloc((size_t)n * sizeof(BriefDesc));
+    BriefDesc *qs = malloc((size_t)n_queries * sizeof(BriefDesc));
+    int *ref = malloc((size_t)n_queries * 4 * sizeof(int));
+    int *ref_r = malloc((size_t)n_queries * sizeof(int));
+    int *out = malloc(MAX_RADIUS_OUT * sizeof(int));
+    int mismatches = 0;
+
+    if (!db || !qs || !ref || !ref_r || !out) {
+        perror("malloc");
+        free(db); free(qs); free(ref); free(ref_r); free(out);
+        return 1;
+    }
+    build_gallery(db, n, qs, n_queries);
+
+    double t0 = brief_now_us();
+    for (int q = 0; q < n_queries; q++)
+        brute_knn2(db, n, &qs[q], &ref[q * 4], &ref[q * 4 + 1],
+                   &ref[q * 4 + 2], &ref[q * 4 + 3]);
+    double brute_knn_us = (brief_now_us() - t0) / n_queries;
+
+    t0 = brief_now_us();
+    for (int q = 0; q < n_queries; q++)
+        ref_r[q] = brute_radius(db, n, &qs[q], radius);
+    double brute_r_us = (brief_now_us() - t0) / n_queries;
+
+    long mean_d1 = 0, mean_d2 = 0;
+    for (int q = 0; q < n_queries; q++) {
+        mean_d1 += ref[q * 4 + 1];
+        mean_d2 += ref[q * 4 + 3];
+    }
+    printf("%8d  %-6s  %9s  %10.1f  %10s  %10.1f  %10s   (d1=%ld d2=%ld)\n",
+           n, "brute", "-", brute_knn_us, "100%", brute_r_us, "100%",
+           mean_d1 / n_queries, mean_d2 / n_queries);
+
+    for (int b = 0; b < n_sub; b++) {
+        BriefMih mih;
+        BriefMihScratch sc;
+
+        t0 = brief_now_us();
+        if (brief_mih_build(&mih, db, n, sub_bits[b]) < 0) {
+            fprintf(stderr, "MIH build failed (sub_bits=%d)\n", sub_bits[b]);
+            mismatches++;
+            continue;
+        }
+        double build_ms = (brief_now_us() - t0) / 1000.0;
+        if (brief_mih_scratch_init(&sc, n) < 0) {
+            brief_mih_free(&mih);
+            mismatches++;
+            continue;
+        }
+
+        t0 = brief_now_us();
+        for (int q = 0; q < n_queries; q++) {
+            int i1, d1, i2, d2;
+            brief_mih_knn2(&mih, &sc, &qs[q], BRIEF_BYTES * 8, &i1, &d1, &i2, &d2);
+            const int *r = &ref[q * 4];
+            if (i1 != r[0] || d1 != r[1] || i2 != r[2] || d2 != r[3])
+                mismatches++;
+        }
+        double knn_us = (brief_now_us() - t0) / n_queries;
+        double knn_cand = (double)sc.candidates / n_queries / n * 100.0;
+
+        sc.candidates = 0;
+        t0 = brief_now_us();
+        for (int q = 0; q < n_queries; q++) {
+            int found = brief_mih_radius(&mih, &sc, &qs[q], radius,
+                                         out, MAX_RADIUS_OUT);
+            if (found != ref_r[q])
+                mismatches++;
+        }
+        double r_us = (brief_now_us() - t0) / n_queries;
+        double r_cand = (double)sc.candidates / n_queries / n * 100.0;
+
+        char label[16];
+        snprintf(label, sizeof(label), "mih%d", sub_bits[b]);
+        printf("%8d  %-6s  %9.1f  %10.1f  %9.1f%%  %10.1f  %9.1f%%\n",
+               n, label, build_ms, knn_us, knn_cand, r_us, r_cand);
+
+        brief_mih_scratch_free(&sc);
+        brief_mih_free(&mih);
+    }
+
+    free(db); free(qs); free(ref); free(ref_r); free(out);
+    return mismatches;
+}
+
+/* ================================================================== */
+/* Usage                                                               */
+/* ================================================================== */
+
+static void
+usage(const char *argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [--sizes=128,1024,8192,65536,524288] [--queries=N]\n"
+        "          [--radius=R] [--sub-bits=8|16|0]\n"
+        "\n"
+        "  --sizes=LIST    gallery sizes in descriptors (128 = one frame)\n"
+        "  --queries=N     query descriptors per size (default: %d)\n"
+        "  --radius=R      Hamming radius for r-NN queries (default: %d)\n"
+        "  --sub-bits=N    substring width, 0 = both 8 and 16 (default: 0)\n",
+        argv0, DEFAULT_QUERIES, DEFAULT_RADIUS);
+    exit(1);
+}
+
+/* ================================================================== */
+/* Main                                                                */
+/* ================================================================== */
+
+int
+main(int argc, char *argv[])
+{
+    int sizes[MAX_SIZE_STEPS] = { 128, 1024, 8192, 65536, 524288 };
+    int n_sizes = 5;
+    int queries = DEFAULT_QUERIES;
+    int radius = DEFAULT_RADIUS;
+    int sub_bits[2] = { 8, 16 };
+    int n_sub = 2;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--sizes=", 8) == 0)
+            n_sizes = parse_int_list(argv[i] + 8, sizes, MAX_SIZE_STEPS);
+        else if (strncmp(argv[i], "--queries=", 10) == 0)
+            queries = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "--radius=", 9) == 0)
+            radius = atoi(argv[i] + 9);
+        else if (strncmp(argv[i], "--sub-bits=", 11) == 0) {
+            int b = atoi(argv[i] + 11);
+            if (b == 8 || b == 16) {
+                sub_bits[0] = b;
+                n_sub = 1;
+            } else if (b != 0)
+                usage(argv[0]);
+        } else
+            usage(argv[0]);
+    }
+    if (queries < 1 || n_sizes < 1 || radius < 0 || radius > BRIEF_BYTES * 8)
+        usage(argv[0]);
+    for (int s = 0; s < n_sizes; s++)
+        if (sizes[s] < 2)
+            usage(argv[0]);
+
+    printf("Per-query latency (us), %d queries, r-NN radius %d\n\n", queries, radius);
+    printf("%8s  %-6s  %9s  %10s  %10s  %10s  %10s\n",
+           "gallery", "method", "build ms", "2-NN us", "2-NN cand",
+           "r-NN us", "r-NN cand");
+
+    int mismatches = 0;
+    for (int s = 0; s < n_sizes; s++)
+        mismatches += bench_size(sizes[s], queries, radius, sub_bits, n_sub);
+
+    printf("\nExactness: %s (%d mismatches vs brute force)\n",
+           mismatches ? "FAIL" : "OK", mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,557 @@
+/*
+ * msg-replay.c — Goodix USB receive path replay (P15, doc 20 §16)
+ *
+ * Replays the bulk-IN transfers of a recorded session through two receive
+ * paths and checks that they deliver the same messages:
+ *
+ *   current    model of goodix.c: each transfer in a fresh buffer,
+ *              g_realloc() + memcpy() onto priv->data, goodix_decode_pack()
+ *              tried on the whole buffer, pack and protocol payloads
+ *              g_memdup()'d, checksums computed over the finished message
+ *   assembler  goodix-msg.c: transfers land in the receiver's buffer via
+ *              goodix_msg_rx_span()/_commit(), checksum summed as they
+ *              land, messages dispatched as pointers into the buffer
+ *
+ * Input is the pcapng umockdev/usbmon recording used by the driver tests
+ * (tests/goodixtls511/custom.pcapng, link type USB_LINUX or
+ * USB_LINUX_MMAPPED): every completed bulk-IN transfer with data is one
+ * chunk, in order.  Without a recording, --synthetic builds a session of
+ * plaintext protocol replies and TLS image records and splits it into
+ * transfers of each --chunks size.
+ *
+ * Usage:
+ *   msg-replay [--repeat=N] FILE.pcapng
+ *   msg-replay [--repeat=N] --synthetic[=SCANS] [--chunks=C1,C2,...]
+ *
+ * Build:  see Makefile
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "goodix-msg.h"
+
+/* ================================================================== */
+/* Defaults                                                            */
+/* ================================================================== */
+
+#define DEFAULT_REPEAT      200
+#define DEFAULT_SCANS       20
+#define MAX_LIST            16
+#define RX_INITIAL          (32 * 1024)
+#define IMAGE_RECORD        10613   /* TLS header + 10 560 packed + MAC/IV */
+
+static double
+now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static void *
+xrealloc(void *p, size_t n)
+{
+    p = realloc(p, n ? n : 1);
+    if (!p) { perror("realloc"); exit(1); }
+    return p;
+}
+
+/* ================================================================== */
+/* Chunk list                                                          */
+/* ================================================================== */
+
+typedef struct {
+    uint8_t *data;
+    size_t   len, alloc;
+    size_t  *off;           /* chunk i is data[off[i] … off[i+1]) */
+    size_t   n, n_alloc;
+} Chunks;
+
+static void
+chunks_add(Chunks *c, const uint8_t *p, size_t n)
+{
+    if (c->len + n > c->alloc) {
+        c->alloc = (c->len + n) * 2;
+        c->data = xrealloc(c->data, c->alloc);
+    }
+    if (c->n + 2 > c->n_alloc) {
+        c->n_alloc = c->n_alloc ? c->n_alloc * 2 : 256;
+        c->off = xrealloc(c->off, c->n_alloc * sizeof(size_t));
+    }
+    memcpy(c->data + c->len, p, n);
+    c->off[c->n] = c->len;
+    c->len += n;
+    c->off[++c->n] = c->len;
+}
+
+static void
+chunks_free(Chunks *c)
+{
+    free(c->data);
+    free(c->off);
+    memset(c, 0, sizeof(*c));
+}
+
+/* ================================================================== */
+/* pcapng (usbmon) reader                                              */
+/* ================================================================== */
+
+#define LINKTYPE_USB_LINUX          189
+#define LINKTYPE_USB_LINUX_MMAPPED  220
+#define MAX_INTERFACES              16
+
+static uint32_t
+rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* usbmon packet: completed ('C') bulk (3) IN transfer with captured data */
+static void
+usbmon_packet(Chunks *c, const uint8_t *p, size_t n, int linktype)
+{
+    size_t hdr = linktype == LINKTYPE_USB_LINUX_MMAPPED ? 64 : 48;
+    if (n < hdr || p[8] != 'C' || p[9] != 3 || !(p[10] & 0x80))
+        return;
+    size_t len_cap = rd32(p + 36);
+    if (len_cap == 0 || hdr + len_cap > n)
+        return;
+    chunks_add(c, p + hdr, len_cap);
+}
+
+static int
+read_pcapng(const char *path, Chunks *c)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return -1; }
+
+    int linktype[MAX_INTERFACES];
+    int n_if = 0;
+    uint8_t *blk = NULL;
+    size_t blk_alloc = 0;
+    uint8_t head[8];
+
+    while (fread(head, 1, 8, f) == 8) {
+        uint32_t type = rd32(head), len = rd32(head + 4);
+        if (len < 12 || len % 4 != 0) {
+            fprintf(stderr, "%s: bad block length %u\n", path, len);
+            break;
+        }
+        if (len > blk_alloc) {
+            blk_alloc = len;
+            blk = xrealloc(blk, blk_alloc);
+        }
+        memcpy(blk, head, 8);
+        if (fread(blk + 8, 1, len - 8, f) != len - 8)
+            break;
+
+        if (type == 0x0a0d0d0a) {                       /* section header */
+            if (rd32(blk + 8) != 0x1a2b3c4d) {
+                fprintf(stderr, "%s: big-endian pcapng not supported\n", path);
+                break;
+            }
+            n_if = 0;
+        } else if (type == 1 && n_if < MAX_INTERFACES) { /* interface description */
+            linktype[n_if++] = blk[8] | blk[9] << 8;
+        } else if (type == 6 && len >= 32) {            /* enhanced packet */
+            uint32_t ifc = rd32(blk + 8), cap = rd32(blk + 20);
+            if (ifc < (uint32_t)n_if && 28 + cap <= len &&
+                (linktype[ifc] == LINKTYPE_USB_LINUX ||
+                 linktype[ifc] == LINKTYPE_USB_LINUX_MMAPPED))
+                usbmon_packet(c, blk + 28, cap, linktype[ifc]);
+        }
+    }
+
+    free(blk);
+    fclose(f);
+    return c->n > 0 ? 0 : -1;
+}
+
+/* ================================================================== */
+/* Synthetic session                                                   */
+/* ================================================================== */
+
+static uint32_t
+xorshift(uint32_t *s)
+{
+    *s ^= *s << 13; *s ^= *s >> 17; *s ^= *s << 5;
+    return *s;
+}
+
+static size_t
+put_pack(uint8_t *out, uint8_t flags, const uint8_t *payload, size_t n)
+{
+    out[0] = flags;
+    out[1] = (uint8_t)n;
+    out[2] = (uint8_t)(n >> 8);
+    out[3] = (uint8_t)(out[0] + out[1] + out[2]);
+    memcpy(out + GOODIX_PACK_HEADER, payload, n);
+    return GOODIX_PACK_HEADER + n;
+}
+
+/* Protocol reply `cmd` with `n` data bytes, checksummed (or 0x88) */
+static size_t
+put_protocol(uint8_t *out, uint8_t cmd, const uint8_t *data, size_t n, int checksum)
+{
+    uint8_t msg[GOODIX_PROTOCOL_HEADER + 256 + 1];
+    msg[0] = cmd;
+    msg[1] = (uint8_t)(n + 1);
+    msg[2] = (uint8_t)((n + 1) >> 8);
+    memcpy(msg + GOODIX_PROTOCOL_HEADER, data, n);
+    uint8_t sum = 0;
+    for (size_t i = 0; i < GOODIX_PROTOCOL_HEADER + n; i++)
+        sum += msg[i];
+    msg[GOODIX_PROTOCOL_HEADER + n] = checksum ? (uint8_t)(0xaa - sum) : GOODIX_PROTOCOL_NO_CHECKSUM;
+    return put_pack(out, GOODIX_FLAGS_MSG_PROTOCOL, msg, GOODIX_PROTOCOL_HEADER + n + 1);
+}
+
+/* Per scan: ACKs and short replies for the scan SSM commands (0xae finger
+ * detect, 0x36, 0x32, 0x20, 0x34), one TLS image record, and one corrupted
+ * reply so the checksum path is exercised.  The message stream is split
+ * into transfers of `chunk` bytes; a transfer never spans two messages. */
+static void
+synthetic_session(int scans, size_t chunk, Chunks *c)
+{
+    static const uint8_t cmds[] = { 0xae, 0x36, 0x32, 0x20, 0x34 };
+    uint32_t rng = 0x6d7367;
+    uint8_t *msg = malloc(GOODIX_PACK_HEADER + IMAGE_RECORD);
+    uint8_t data[256];
+    if (!msg) { perror("malloc"); exit(1); }
+
+    for (int s = 0; s < scans; s++) {
+        for (int k = 0; k < 12; k++) {
+            size_t n;
+            if (k == 11) {
+                uint8_t *rec = msg + GOODIX_PACK_HEADER;
+                rec[0] = 0x17; rec[1] = 0x03; rec[2] = 0x03;
+                rec[3] = (uint8_t)((IMAGE_RECORD - 5) >> 8);
+                rec[4] = (uint8_t)(IMAGE_RECORD - 5);
+                for (size_t i = 5; i < IMAGE_RECORD; i++)
+                    rec[i] = (uint8_t)xorshift(&rng);
+                n = put_pack(msg, GOODIX_FLAGS_TLS, rec, IMAGE_RECORD);
+            } else {
+                uint8_t cmd = k % 2 == 0 ? 0xb0 : cmds[(k / 2) % sizeof(cmds)];
+                size_t len = cmd == 0xb0 ? 2 : 1 + xorshift(&rng) % 64;
+                for (size_t i = 0; i < len; i++)
+                    data[i] = (uint8_t)xorshift(&rng);
+                n = put_protocol(msg, cmd, data, len, k != 3);
+                if (k == 9)
+                    msg[n - 1] ^= 0x5a;     /* bad checksum */
+            }
+            for (size_t off = 0; off < n; off += chunk)
+                chunks_add(c, msg + off, n - off < chunk ? n - off : chunk);
+        }
+    }
+    free(msg);
+}
+
+/* ================================================================== */
+/* Delivered messages                                                  */
+/* ================================================================== */
+
+typedef struct {
+    uint8_t  flags, cmd;
+    int8_t   pack_ok, protocol_ok;
+    uint32_t len, data_len;
+    uint64_t hash;          /* FNV-1a of the delivered payload / data */
+} Delivered;
+
+typedef struct {
+    Delivered *v;
+    size_t     n, alloc;
+    uint64_t   bytes_copied;
+    uint64_t   allocs;
+    int        record;      /* 0 while timing */
+} Sink;
+
+static uint64_t
+fnv1a(const uint8_t *p, size_t n)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ p[i]) * 0x100000001b3ull;
+    return h;
+}
+
+static void
+deliver(Sink *s, const GoodixMsg *m)
+{
+    if (!s->record)
+        return;
+    if (s->n == s->alloc) {
+        s->alloc = s->alloc ? s->alloc * 2 : 256;
+        s->v = xrealloc(s->v, s->alloc * sizeof(Delivered));
+    }
+    Delivered *d = &s->v[s->n++];
+    memset(d, 0, sizeof(*d));       /* padding is compared too */
+    d->flags = m->flags;
+    d->cmd = m->cmd;
+    d->pack_ok = (int8_t)m->pack_ok;
+    d->protocol_ok = (int8_t)m->protocol_ok;
+    d->len = (uint32_t)m->len;
+    d->data_len = (uint32_t)m->data_len;
+    d->hash = m->protocol_ok >= 0 && m->data ? fnv1a(m->data, m->data_len)
+                                             : fnv1a(m->payload, m->len);
+}
+
+/* ================================================================== */
+/* Current path (goodix.c model)                                       */
+/* ================================================================== */
+
+static size_t
+le16(const uint8_t *p)
+{
+    return (size_t)p[0] | (size_t)p[1] << 8;
+}
+
+static void
+run_current(const Chunks *c, Sink *s)
+{
+    uint8_t *data = NULL;       /* priv->data */
+    size_t length = 0;          /* priv->length */
+
+    for (size_t i = 0; i < c->n; i++) {
+        size_t n = c->off[i + 1] - c->off[i];
+        uint8_t *transfer = malloc(n);              /* fpi_usb_transfer_fill_bulk */
+        if (!transfer) { perror("malloc"); exit(1); }
+        memcpy(transfer, c->data + c->off[i], n);   /* the USB write */
+
+        data = xrealloc(data, length + n);
+        memcpy(data + length, transfer, n);
+        length += n;
+        s->bytes_copied += n;
+        s->allocs += 2;
+        free(transfer);
+
+        /* goodix_decode_pack() until nothing complete is left */
+        while (length >= GOODIX_PACK_HEADER &&
+               length >= GOODIX_PACK_HEADER + le16(data + 1)) {
+            GoodixMsg m = { 0 };
+            size_t plen = le16(data + 1);
+            m.flags = data[0];
+            m.pack_ok = (uint8_t)(data[0] + data[1] + data[2]) == data[3];
+            uint8_t *payload = malloc(plen ? plen : 1);
+            if (!payload) { perror("malloc"); exit(1); }
+            memcpy(payload, data + GOODIX_PACK_HEADER, plen);
+            s->bytes_copied += plen;
+            s->allocs++;
+            m.payload = payload;
+            m.len = plen;
+            m.protocol_ok = -1;
+
+            uint8_t *proto = NULL;
+            if (m.flags == GOODIX_FLAGS_MSG_PROTOCOL) {   /* goodix_decode_protocol() */
+                size_t dlen = plen >= GOODIX_PROTOCOL_HEADER ? le16(payload + 1) : 0;
+                m.protocol_ok = 0;
+                if (dlen >= 1 && GOODIX_PROTOCOL_HEADER + dlen <= plen) {
+                    uint8_t sum = 0;
+                    for (size_t k = 0; k < GOODIX_PROTOCOL_HEADER + dlen - 1; k++)
+                        sum += payload[k];
+                    uint8_t checksum = payload[GOODIX_PROTOCOL_HEADER + dlen - 1];
+                    proto = malloc(dlen);
+                    if (!proto) { perror("malloc"); exit(1); }
+                    memcpy(proto, payload + GOODIX_PROTOCOL_HEADER, dlen - 1);
+                    s->bytes_copied += dlen - 1;
+                    s->allocs++;
+                    m.cmd = payload[0];
+                    m.data = proto;
+                    m.data_len = dlen - 1;
+                    m.protocol_ok = checksum == GOODIX_PROTOCOL_NO_CHECKSUM ||
+                                    checksum == (uint8_t)(0xaa - sum);
+                }
+            }
+            deliver(s, &m);
+            free(proto);
+            free(payload);
+
+            size_t used = GOODIX_PACK_HEADER + plen;
+            memmove(data, data + used, length - used);
+            s->bytes_copied += length - used;
+            length -= used;
+        }
+    }
+    free(data);
+}
+
+/* ================================================================== */
+/* Assembler path                                                      */
+/* ================================================================== */
+
+static void
+run_assembler(const Chunks *c, GoodixMsgRx *rx, Sink *s)
+{
+    goodix_msg_rx_reset(rx);
+    for (size_t i = 0; i < c->n; i++) {
+        size_t n = c->off[i + 1] - c->off[i];
+        uint8_t *span;
+        if (goodix_msg_rx_span(rx, &span) >= n) {
+            memcpy(span, c->data + c->off[i], n);   /* the USB write */
+            if (goodix_msg_rx_commit(rx, n) != 0) { perror("commit"); exit(1); }
+        } else {
+            /* transfer larger than the free space: copy in */
+            if (goodix_msg_rx_push(rx, c->data + c->off[i], n) != 0) { perror("push"); exit(1); }
+            s->bytes_copied += n;
+        }
+        GoodixMsg m;
+        while (goodix_msg_rx_next(rx, &m))
+            deliver(s, &m);
+    }
+}
+
+/* ================================================================== */
+/* Usage                                                               */
+/* ================================================================== */
+
+static void
+usage(const char *argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [--repeat=N] FILE.pcapng\n"
+        "       %s [--repeat=N] --synthetic[=SCANS] [--chunks=C1,C2,...]\n"
+        "\n"
+        "  --repeat=N        timed replays of the session (default: %d)\n"
+        "  --synthetic[=N]   generated session of N scans (default: %d)\n"
+        "  --chunks=...      synthetic USB transfer sizes (default: 64,512,8192)\n",
+        argv0, argv0, DEFAULT_REPEAT, DEFAULT_SCANS);
+    exit(1);
+}
+
+static int
+parse_list(const char *s, size_t *out)
+{
+    int n = 0;
+    while (*s && n < MAX_LIST) {
+        char *end;
+        long v = strtol(s, &end, 10);
+        if (end == s || v < 1) return -1;
+        out[n++] = (size_t)v;
+        s = end;
+        if (*s == ',') s++;
+        else if (*s) return -1;
+    }
+    return n;
+}
+
+/* ================================================================== */
+/* Main                                                                */
+/* ================================================================== */
+
+/* Check, then time both paths on one chunk list; returns failures */
+static int
+replay(const char *label, const Chunks *c, int repeat)
+{
+    size_t max_transfer = 0;
+    for (size_t i = 0; i < c->n; i++)
+        if (c->off[i + 1] - c->off[i] > max_transfer)
+            max_transfer = c->off[i + 1] - c->off[i];
+
+    GoodixMsgRx rx;
+    if (goodix_msg_rx_init(&rx, RX_INITIAL, max_transfer) != 0) { perror("malloc"); exit(1); }
+
+    Sink a = { .record = 1 }, b = { .record = 1 };
+    run_current(c, &a);
+    run_assembler(c, &rx, &b);
+
+    int failures = 0;
+    if (a.n != b.n) {
+        fprintf(stderr, "  MISMATCH (%s): %zu vs %zu messages\n", label, a.n, b.n);
+        failures++;
+    }
+    for (size_t i = 0; i < a.n && i < b.n; i++)
+        if (memcmp(&a.v[i], &b.v[i], sizeof(Delivered)) != 0) {
+            fprintf(stderr, "  MISMATCH (%s): message %zu differs\n", label, i);
+            failures++;
+            break;
+        }
+
+    size_t n_proto = 0, n_tls = 0, bad = 0;
+    for (size_t i = 0; i < a.n; i++) {
+        if (a.v[i].flags == GOODIX_FLAGS_MSG_PROTOCOL) n_proto++;
+        else if (a.v[i].flags == GOODIX_FLAGS_TLS) n_tls++;
+        if (!a.v[i].pack_ok || a.v[i].protocol_ok == 0) bad++;
+    }
+    const double n_msg = a.n ? (double)a.n : 1.0;
+
+    Sink ta = { 0 }, tb = { 0 };
+    double t0 = now_us();
+    for (int r = 0; r < repeat; r++)
+        run_current(c, &ta);
+    double t1 = now_us();
+    for (int r = 0; r < repeat; r++)
+        run_assembler(c, &rx, &tb);
+    double t2 = now_us();
+
+    printf("  %-14s %6zu transfers  %5zu msgs (%zu protocol, %zu TLS, %zu bad)  %8.0f KB\n",
+           label, c->n, a.n, n_proto, n_tls, bad, c->len / 1024.0);
+    printf("    %-10s  %10.3f us/msg  %10.0f B copied/msg  %6.2f allocs/msg\n", "current",
+           (t1 - t0) / repeat / n_msg, (double)a.bytes_copied / n_msg, (double)a.allocs / n_msg);
+    printf("    %-10s  %10.3f us/msg  %10.0f B copied/msg  %6.2f allocs/msg\n", "assembler",
+           (t2 - t1) / repeat / n_msg, (double)b.bytes_copied / n_msg, (double)b.allocs / n_msg);
+
+    free(a.v);
+    free(b.v);
+    goodix_msg_rx_free(&rx);
+    return failures;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int repeat = DEFAULT_REPEAT;
+    int scans = 0;
+    const char *path = NULL;
+    size_t chunks[MAX_LIST] = { 64, 512, 8192 };
+    int n_chunks = 3;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--repeat=", 9) == 0)
+            repeat = atoi(argv[i] + 9);
+        else if (strcmp(argv[i], "--synthetic") == 0)
+            scans = DEFAULT_SCANS;
+        else if (strncmp(argv[i], "--synthetic=", 12) == 0)
+            scans = atoi(argv[i] + 12);
+        else if (strncmp(argv[i], "--chunks=", 9) == 0)
+            n_chunks = parse_list(argv[i] + 9, chunks);
+        else if (argv[i][0] == '-' || path)
+            usage(argv[0]);
+        else
+            path = argv[i];
+    }
+    if (repeat < 1 || n_chunks < 1 || (!path) == (scans < 1))
+        usage(argv[0]);
+
+    int failures = 0;
+    if (path) {
+        Chunks c = { 0 };
+        if (read_pcapng(path, &c) != 0) {
+            fprintf(stderr, "%s: no bulk-IN transfers found\n", path);
+            chunks_free(&c);
+            return 1;
+        }
+        printf("msg-replay: %s, %d replays\n\n", path, repeat);
+        failures += replay("recorded", &c, repeat);
+        chunks_free(&c);
+    } else {
+        printf("msg-replay: synthetic session, %d scans, %d replays\n\n", scans, repeat);
+        for (int k = 0; k < n_chunks; k++) {
+            Chunks c = { 0 };
+            char label[32];
+            synthetic_session(scans, chunks[k], &c);
+            snprintf(label, sizeof(label), "chunk %zu", chunks[k]);
+            failures += replay(label, &c, repeat);
+            chunks_free(&c);
+        }
+    }
+
+    if (failures) {
+        printf("\n  %d mismatch(es) between the receive paths\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -12,9 +12,16 @@
  *
  * Outputs a processed PGM that can be fed to sigfm-batch.
  *
+ * The 8-bit path runs the fused single-pass kernel from goodix-preprocess.c
+ * (P9, doc 20 §10), the module the driver links.  The multi-pass functions
+ * below are kept verbatim as the reference: --reference selects them,
+ * --check runs both on every frame and fails on any differing pixel, and
+ * --selftest does the same on synthetic edge-case frames.
+ *
  * Usage:
  *   replay-pipeline --raw frame.bin --cal calibration.bin -o output.pgm
  *                   [--boost=N] [--width=W] [--height=H] [--scan-width=S]
+ *   replay-pipeline --selftest
  *
  * Build:  see Makefile
  *
@@ -25,6 +32,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <time.h>
+
+#include "goodix-preprocess.h"
 
 /* ================================================================== */
 /* Parameters (matching goodix5xx driver defaults)                     */
@@ -34,6 +44,14 @@
 #define DEFAULT_WIDTH       64
 #define DEFAULT_HEIGHT      80
 #define DEFAULT_BOOST       4
+#define CHECK_REPEAT        200     /* --check: timing repetitions per frame */
+
+/* 8-bit pipeline implementation */
+enum {
+    PP_FUSED,       /* goodix_preprocess_frame() */
+    PP_REFERENCE,   /* multi-pass copy of goodix5xx.c */
+    PP_CHECK,       /* both, compare output, time each */
+};
 
 /* Clamp macro (matching GLib CLAMP) */
 #define CLAMP(x, lo, hi) ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
@@ -240,6 +258,169 @@ unsharp_mask_wide_to_8(uint16_t *wide, uint8_t *out, int w, int h, int boost)
     free(blurred);
 }
 
+/* ================================================================== */
+/* 8-bit pipeline: reference and fused                                 */
+/* ================================================================== */
+
+/* The driver's multi-pass sequence: subtract, percentile squash, unsharp
+ * over the full scan width, then a left-aligned crop (goodix511
+ * crop_frame() copies columns 0..out_width). */
+static int
+reference_frame(uint16_t *frame, uint16_t *cal, int scan_width, int height,
+                int out_width, int boost, uint8_t *out)
+{
+    int frame_size = scan_width * height;
+
+    if (cal)
+        linear_subtract_inplace(frame, cal, (uint16_t)frame_size);
+
+    uint8_t *squashed = malloc((size_t)frame_size);
+    if (!squashed) { perror("malloc"); return -1; }
+
+    squash_frame_percentile(frame, squashed, (uint16_t)frame_size);
+    if (boost > 0)
+        unsharp_mask_inplace(squashed, scan_width, height, boost);
+
+    for (int y = 0; y < height; y++)
+        memcpy(out + y * out_width, squashed + y * scan_width, (size_t)out_width);
+
+    free(squashed);
+    return 0;
+}
+
+static double
+now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/* Totals for --check / --selftest */
+static long   check_frames, check_diff_frames, check_diff_px;
+static double check_ref_us, check_fused_us;
+
+/* Run both implementations on copies of `raw`; returns the number of
+ * differing output pixels.  repeat > 0 also times each path. */
+static int
+check_frame(const char *name, const uint16_t *raw, uint16_t *cal,
+            int scan_width, int height, int out_width, int boost, int repeat)
+{
+    size_t n = (size_t)scan_width * height;
+    uint16_t *work = malloc(n * sizeof(uint16_t));
+    uint8_t *a = malloc((size_t)out_width * height);
+    uint8_t *b = malloc((size_t)out_width * height);
+    if (!work || !a || !b) {
+        perror("malloc");
+        free(work); free(a); free(b);
+        return -1;
+    }
+
+    memcpy(work, raw, n * sizeof(uint16_t));
+    reference_frame(work, cal, scan_width, height, out_width, boost, a);
+    memcpy(work, raw, n * sizeof(uint16_t));
+    if (goodix_preprocess_frame(work, cal, scan_width, height, out_width, boost, b) != 0) {
+        fprintf(stderr, "%s: unsupported dimensions for fused kernel\n", name);
+        free(work); free(a); free(b);
+        return -1;
+    }
+
+    int diff = 0, first = -1;
+    for (int i = 0; i < out_width * height; i++)
+        if (a[i] != b[i]) {
+            if (first < 0) first = i;
+            diff++;
+        }
+    if (diff)
+        fprintf(stderr, "  MISMATCH %s: %d px differ, first at (%d,%d): ref %d fused %d\n",
+                name, diff, first % out_width, first / out_width, a[first], b[first]);
+
+    for (int r = 0; r < repeat; r++) {
+        memcpy(work, raw, n * sizeof(uint16_t));
+        double t0 = now_us();
+        reference_frame(work, cal, scan_width, height, out_width, boost, a);
+        double t1 = now_us();
+        memcpy(work, raw, n * sizeof(uint16_t));
+        goodix_preprocess_frame(work, cal, scan_width, height, out_width, boost, b);
+        double t2 = now_us();
+        check_ref_us += t1 - t0;
+        check_fused_us += t2 - t1;
+    }
+
+    check_frames++;
+    if (diff) { check_diff_frames++; check_diff_px += diff; }
+    free(work); free(a); free(b);
+    return diff;
+}
+
+static void
+check_report(int repeat)
+{
+    printf("\n  Fused vs reference: %ld frames, %ld differ (%ld px)\n",
+           check_frames, check_diff_frames, check_diff_px);
+    if (repeat > 0 && check_frames > 0) {
+        double runs = (double)check_frames * repeat;
+        printf("  Time/frame:         reference %.1f us, fused %.1f us (%.2fx)\n",
+               check_ref_us / runs, check_fused_us / runs,
+               check_fused_us > 0 ? check_ref_us / check_fused_us : 0.0);
+    }
+}
+
+/* Synthetic frames covering the paths a capture corpus rarely hits:
+ * the degenerate-histogram linear fallback, the subtract's uint16 wrap
+ * (raw above calibration), saturated and single-row frames, and odd
+ * sizes with and without crop. */
+static int
+selftest(void)
+{
+    static const int dims[][3] = {      /* scan_width, height, out_width */
+        { DEFAULT_SCAN_WIDTH, DEFAULT_HEIGHT, DEFAULT_WIDTH },
+        { DEFAULT_SCAN_WIDTH, DEFAULT_HEIGHT, DEFAULT_SCAN_WIDTH },
+        { DEFAULT_SCAN_WIDTH, DEFAULT_HEIGHT, DEFAULT_SCAN_WIDTH - 1 },
+        { 7, 5, 3 }, { 5, 1, 5 }, { 1, 9, 1 }, { 2, 2, 1 },
+    };
+    static const int boosts[] = { 0, 1, 2, DEFAULT_BOOST, 9 };
+    uint32_t rng = 0x9e3779b9u;
+    char name[96];
+
+    for (size_t d = 0; d < sizeof(dims) / sizeof(dims[0]); d++) {
+        int sw = dims[d][0], h = dims[d][1], ow = dims[d][2];
+        size_t n = (size_t)sw * h;
+        uint16_t *raw = malloc(n * sizeof(uint16_t));
+        uint16_t *cal = malloc(n * sizeof(uint16_t));
+        if (!raw || !cal) { perror("malloc"); free(raw); free(cal); return -1; }
+
+        for (int kind = 0; kind < 6; kind++) {
+            for (size_t i = 0; i < n; i++) {
+                rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+                switch (kind) {
+                case 0: raw[i] = (uint16_t)rng; break;                     /* full range */
+                case 1: raw[i] = (uint16_t)(0x4000 + (rng & 0x0fff)); break; /* sensor-like */
+                case 2: raw[i] = 0x1234; break;                            /* flat */
+                case 3: raw[i] = (rng & 1) ? 0x2010 : 0x20f0; break;       /* one bin */
+                case 4: raw[i] = (rng & 7) ? 0xffff : 0; break;            /* saturated */
+                default: raw[i] = (uint16_t)(0x8000 + (rng & 0x3ff)); break;
+                }
+                cal[i] = (uint16_t)(0x8000 + ((rng >> 16) & 0x7ff));
+            }
+            for (size_t b = 0; b < sizeof(boosts) / sizeof(boosts[0]); b++) {
+                snprintf(name, sizeof(name), "%dx%d→%d kind %d boost %d",
+                         sw, h, ow, kind, boosts[b]);
+                if (check_frame(name, raw, NULL, sw, h, ow, boosts[b], 0) < 0 ||
+                    check_frame(name, raw, cal, sw, h, ow, boosts[b], 0) < 0) {
+                    free(raw); free(cal);
+                    return -1;
+                }
+            }
+        }
+        free(raw);
+        free(cal);
+    }
+
+    check_report(0);
+    return check_diff_frames ? -1 : 0;
+}
+
 /* ================================================================== */
 /* File I/O                                                            */
 /* ================================================================== */
@@ -294,11 +475,15 @@ usage(const char *argv0)
         "          [--no-unsharp]    skip unsharp mask step\n"
         "          [--12bit]         A6: 12-bit working space (sharpen in 16-bit)\n"
         "          [--batch DIR]     process all raw_*.bin in DIR\n"
+        "          [--reference]     8-bit path: multi-pass driver copy, not fused\n"
+        "          [--check]         run both 8-bit paths, compare and time them\n"
+        "       %s --selftest         fused vs reference on synthetic frames\n"
         "\n"
         "Replays the goodix5xx preprocessing pipeline offline.\n"
         "Raw .bin files: uint16 LE arrays (%d×%d = %d bytes)\n",
         argv0,
         DEFAULT_BOOST, DEFAULT_SCAN_WIDTH, DEFAULT_HEIGHT, DEFAULT_WIDTH,
+        argv0,
         DEFAULT_SCAN_WIDTH, DEFAULT_HEIGHT,
         DEFAULT_SCAN_WIDTH * DEFAULT_HEIGHT * 2);
     exit(1);
@@ -311,7 +496,7 @@ usage(const char *argv0)
 static int
 process_frame(const char *raw_path, const char *cal_path, const char *out_path,
               int scan_width, int height, int out_width, int boost,
-              int do_crop, int do_unsharp, int wide_mode)
+              int do_crop, int do_unsharp, int wide_mode, int pp_mode)
 {
     int frame_size = scan_width * height;
 
@@ -321,58 +506,57 @@ process_frame(const char *raw_path, const char *cal_path, const char *out_path,
     /* Step 1: calibration subtract (only if explicitly requested).
      * NOTE: raw_NNNN.bin files from FP_SAVE_RAW are already post-cal —
      * pass --cal only for truly uncalibrated captures. */
+    uint16_t *cal = NULL;
     if (cal_path) {
-        uint16_t *cal = read_raw(cal_path, frame_size);
-        if (!cal) {
+        cal = read_raw(cal_path, frame_size);
+        if (!cal)
             fprintf(stderr, "Warning: cannot read calibration, skipping subtract\n");
-        } else {
-            linear_subtract_inplace(frame, cal, (uint16_t)frame_size);
-            free(cal);
-        }
     }
 
-    uint8_t *squashed = malloc((size_t)frame_size);
-    if (!squashed) { perror("malloc"); free(frame); return -1; }
+    /* Step 4 parameters: left-aligned crop (matches goodix511 crop_frame()).
+     * A previous center crop produced different pixel data than the driver. */
+    int final_w = (do_crop && out_width < scan_width) ? out_width : scan_width;
+    int eff_boost = do_unsharp ? boost : 0;
 
-    if (wide_mode && do_unsharp && boost > 0) {
+    uint8_t *output = malloc((size_t)final_w * height);
+    if (!output) { perror("malloc"); free(cal); free(frame); return -1; }
+
+    int ret = 0;
+    if (wide_mode && eff_boost > 0) {
         /* A6: percentile stretch → 16-bit, unsharp in 16-bit, quantize → 8-bit */
         uint16_t *wide = malloc((size_t)frame_size * sizeof(uint16_t));
-        if (!wide) { perror("malloc"); free(squashed); free(frame); return -1; }
+        uint8_t *squashed = malloc((size_t)frame_size);
+        if (!wide || !squashed) {
+            perror("malloc");
+            free(wide); free(squashed); free(output); free(cal); free(frame);
+            return -1;
+        }
+        if (cal)
+            linear_subtract_inplace(frame, cal, (uint16_t)frame_size);
         squash_frame_percentile_wide(frame, wide, (uint16_t)frame_size);
-        free(frame);
         unsharp_mask_wide_to_8(wide, squashed, scan_width, height, boost);
-        free(wide);
-    } else {
-        /* Original 8-bit path */
-        squash_frame_percentile(frame, squashed, (uint16_t)frame_size);
-        free(frame);
-        if (do_unsharp && boost > 0)
-            unsharp_mask_inplace(squashed, scan_width, height, boost);
-    }
-
-    /* Step 4: crop */
-    int final_w = do_crop ? out_width : scan_width;
-    uint8_t *output;
-
-    if (do_crop && out_width < scan_width) {
-        /* Left-aligned crop: matches driver's goodix511 crop_frame()
-         * which copies columns 0..out_width from the scan_width image.
-         * Previous center crop (offset = (scan_width - out_width) / 2)
-         * produced different pixel data than the driver. */
-        int offset = 0;
-        output = malloc((size_t)out_width * height);
-        if (!output) { perror("malloc"); free(squashed); return -1; }
         for (int y = 0; y < height; y++)
-            memcpy(output + y * out_width,
-                   squashed + y * scan_width + offset,
-                   (size_t)out_width);
+            memcpy(output + y * final_w, squashed + y * scan_width, (size_t)final_w);
+        free(wide);
         free(squashed);
-    } else {
-        output = squashed;
-        final_w = scan_width;
+    } else if (pp_mode == PP_REFERENCE) {
+        ret = reference_frame(frame, cal, scan_width, height, final_w, eff_boost, output);
+    } else if (pp_mode == PP_CHECK) {
+        ret = check_frame(raw_path, frame, cal, scan_width, height, final_w,
+                          eff_boost, CHECK_REPEAT) != 0 ? -1 : 0;
+        if (ret == 0)
+            goodix_preprocess_frame(frame, cal, scan_width, height, final_w,
+                                    eff_boost, output);
+    } else if (goodix_preprocess_frame(frame, cal, scan_width, height, final_w,
+                                       eff_boost, output) != 0) {
+        fprintf(stderr, "%s: unsupported dimensions %d×%d\n", raw_path, scan_width, height);
+        ret = -1;
     }
+    free(cal);
+    free(frame);
 
-    int ret = write_pgm(out_path, output, final_w, height);
+    if (ret == 0)
+        ret = write_pgm(out_path, output, final_w, height);
     free(output);
 
     if (ret == 0)
@@ -391,7 +575,7 @@ process_frame(const char *raw_path, const char *cal_path, const char *out_path,
 static int
 batch_process(const char *dir, const char *cal_path,
               int scan_width, int height, int out_width, int boost,
-              int do_crop, int do_unsharp, int wide_mode)
+              int do_crop, int do_unsharp, int wide_mode, int pp_mode)
 {
     DIR *d = opendir(dir);
     if (!d) { perror(dir); return -1; }
@@ -425,7 +609,7 @@ batch_process(const char *dir, const char *cal_path,
 
         if (process_frame(raw_path, cal_path, out_path,
                           scan_width, height, out_width, boost,
-                          do_crop, do_unsharp, wide_mode) == 0)
+                          do_crop, do_unsharp, wide_mode, pp_mode) == 0)
             count++;
         else
             errors++;
@@ -454,6 +638,7 @@ main(int argc, char *argv[])
     int do_crop = 1;
     int do_unsharp = 1;
     int wide_mode = 0;  /* A6: 12-bit working space */
+    int pp_mode = PP_FUSED;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--raw") == 0 && i + 1 < argc)
@@ -478,6 +663,12 @@ main(int argc, char *argv[])
             do_unsharp = 0;
         else if (strcmp(argv[i], "--12bit") == 0)
             wide_mode = 1;
+        else if (strcmp(argv[i], "--reference") == 0)
+            pp_mode = PP_REFERENCE;
+        else if (strcmp(argv[i], "--check") == 0)
+            pp_mode = PP_CHECK;
+        else if (strcmp(argv[i], "--selftest") == 0)
+            return selftest() == 0 ? 0 : 1;
         else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
             usage(argv[0]);
         else {
@@ -490,17 +681,24 @@ main(int argc, char *argv[])
            scan_width, height, out_width, height, boost,
            wide_mode ? "  [12-bit working space]" : "");
 
-    if (batch_dir)
-        return batch_process(batch_dir, cal_path,
-                             scan_width, height, out_width, boost,
-                             do_crop, do_unsharp, wide_mode) == 0 ? 0 : 1;
+    if (batch_dir) {
+        int ret = batch_process(batch_dir, cal_path,
+                                scan_width, height, out_width, boost,
+                                do_crop, do_unsharp, wide_mode, pp_mode);
+        if (pp_mode == PP_CHECK)
+            check_report(CHECK_REPEAT);
+        return ret == 0 ? 0 : 1;
+    }
 
     if (!raw_path || !out_path) {
         fprintf(stderr, "Must specify --raw and -o (or --batch)\n");
         usage(argv[0]);
     }
 
-    return process_frame(raw_path, cal_path, out_path,
-                         scan_width, height, out_width, boost,
-                         do_crop, do_unsharp, wide_mode) == 0 ? 0 : 1;
+    int ret = process_frame(raw_path, cal_path, out_path,
+                            scan_width, height, out_width, boost,
+                            do_crop, do_unsharp, wide_mode, pp_mode);
+    if (pp_mode == PP_CHECK)
+        check_report(CHECK_REPEAT);
+    return ret == 0 ? 0 : 1;
 }
@@ -9,6 +9,12 @@
  *   sigfm-batch --enroll e1.pgm e2.pgm ... --verify v1.pgm v2.pgm ...
  *               [--quality-gate=N] [--score-threshold=N] [--stddev-gate=N]
  *               [--template-study] [--study-threshold=N] [--csv]
+ *               [--rank-signature] [--rank-topk=K] [--kp-budget=N]
+ *               [--match-retry=N] [--retry-budget-ms=M] [--retry-capture-ms=C]
+ *               [--mru-order]
+ *               [--adaptive-enroll=N] [--enroll-min=M] [--novelty-score=S]
+ *               [--incremental-pairs] [--press-interval-ms=I]
+ *               [--burst=K] [--burst-select=best|all] [--burst-frame-ms=F]
  *
  * Build:  see Makefile
  *
@@ -19,15 +25,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "sigfm.h"
+#include "sigfm-defaults.h"
 
 /* ------------------------------------------------------------------ */
 /* Defaults                                                            */
 /* ------------------------------------------------------------------ */
 
-/* Match the driver's score_threshold (goodix511.c, img_dev_class->score_threshold) */
-#define DEFAULT_SCORE_THRESHOLD  6
+/* The driver's score_threshold (goodix511.c, img_dev_class->score_threshold) */
+#define DEFAULT_SCORE_THRESHOLD  SIGFM_SCORE_THRESHOLD
 
 /* Keypoint quality gate — matches fp-image.c sigfm_keypoints_count() < 25 check */
 #define DEFAULT_QUALITY_GATE     25
@@ -60,6 +68,95 @@ pixel_stddev(const unsigned char *img, int npx)
     return (int)sqrt((double)var / npx);
 }
 
+/* ------------------------------------------------------------------ */
+/* Extraction with keypoint budget + timing (P6, doc 20 §7)             */
+/* ------------------------------------------------------------------ */
+
+static double
+now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/* budget 0 = sigfm.c default (MAX_KP).  A smaller budget needs a sigfm.h
+ * with sigfm_extract_budget(), which keeps the strongest FAST responses
+ * with spatial-bucket fairness; older headers build without it. */
+static SigfmImgInfo *
+extract_frame(const unsigned char *pix, int w, int h, int budget)
+{
+#ifdef SIGFM_HAVE_KP_BUDGET
+    if (budget > 0)
+        return sigfm_extract_budget(pix, w, h, budget);
+#endif
+    (void)budget;
+    return sigfm_extract(pix, w, h);
+}
+
+/* ------------------------------------------------------------------ */
+/* Global frame signature — cheap candidate ranking (P1, doc 20 §2)     */
+/* ------------------------------------------------------------------ */
+
+/* Coherence-weighted histogram of block ridge orientation.  Translation
+ * invariant (placement shift is the dominant genuine variation on 64×80)
+ * and ~25 µs per frame at -O2, computed once per probe, so ranking 20
+ * sub-templates costs less than a single sigfm_match_score() call. */
+#define SIG_BLOCK   8
+#define SIG_BINS    16
+
+typedef struct {
+    float bins[SIG_BINS];
+} GlobalSig;
+
+static void
+global_sig_compute(const unsigned char *img, int w, int h, GlobalSig *sig)
+{
+    memset(sig, 0, sizeof(*sig));
+
+    for (int by = 0; by + SIG_BLOCK <= h; by += SIG_BLOCK) {
+        for (int bx = 0; bx + SIG_BLOCK <= w; bx += SIG_BLOCK) {
+            double gxx = 0, gyy = 0, gxy = 0;
+            for (int y = by; y < by + SIG_BLOCK; y++) {
+                if (y == 0 || y == h - 1) continue;
+                for (int x = bx; x < bx + SIG_BLOCK; x++) {
+                    if (x == 0 || x == w - 1) continue;
+                    int gx = img[y * w + x + 1] - img[y * w + x - 1];
+                    int gy = img[(y + 1) * w + x] - img[(y - 1) * w + x];
+                    gxx += gx * gx;
+                    gyy += gy * gy;
+                    gxy += gx * gy;
+                }
+            }
+            double energy = gxx + gyy;
+            if (energy <= 0) continue;
+
+            /* Dominant gradient angle in [0, π) and its coherence */
+            double theta = 0.5 * atan2(2.0 * gxy, gxx - gyy) + M_PI / 2.0;
+            double coh = sqrt((gxx - gyy) * (gxx - gyy) + 4.0 * gxy * gxy) / energy;
+            int bin = (int)(theta / M_PI * SIG_BINS) % SIG_BINS;
+            sig->bins[bin] += (float)coh;
+        }
+    }
+
+    float total = 0;
+    for (int i = 0; i < SIG_BINS; i++)
+        total += sig->bins[i];
+    if (total > 0)
+        for (int i = 0; i < SIG_BINS; i++)
+            sig->bins[i] /= total;
+}
+
+/* L1 distance between normalised histograms: 0 (identical) … 2 (disjoint) */
+static float
+global_sig_dist(const GlobalSig *a, const GlobalSig *b)
+{
+    float d = 0;
+    for (int i = 0; i < SIG_BINS; i++)
+        d += fabsf(a->bins[i] - b->bins[i]);
+    return d;
+}
+
 /* ------------------------------------------------------------------ */
 /* PGM reader (binary P5)                                              */
 /* ------------------------------------------------------------------ */
@@ -117,6 +214,7 @@ read_pgm(const char *path, int *out_w, int *out_h)
 typedef struct {
     SigfmImgInfo *entries[MAX_TEMPLATE_ENTRIES];
     int            scores[MAX_TEMPLATE_ENTRIES]; /* best match score against rest */
+    GlobalSig      sigs[MAX_TEMPLATE_ENTRIES];   /* global signature per entry (P1) */
     int            count;
 } Template;
 
@@ -135,22 +233,87 @@ template_free(Template *t)
 }
 
 static int
-template_add(Template *t, SigfmImgInfo *info)
+template_add(Template *t, SigfmImgInfo *info, const GlobalSig *sig)
 {
     if (t->count >= MAX_TEMPLATE_ENTRIES) return -1;
     t->entries[t->count] = info;
     t->scores[t->count] = 0;
+    t->sigs[t->count] = *sig;
     t->count++;
     return 0;
 }
 
+/* ------------------------------------------------------------------ */
+/* Incremental pair scores (P21, doc 20 §22)                            */
+/* ------------------------------------------------------------------ */
+
+/* Enrollment's all-pairs work (--sort-subtemplates, --diversity-prune)
+ * runs after the last press.  With `enabled`, each frame is matched
+ * against the frames before it as it is added — both directions, so the
+ * cached value is exactly what the end-of-enroll loops would compute — and
+ * those loops read the matrix.  Frames are keyed by pointer: every entry
+ * that reaches the template went through pairs_add().  `late` counts
+ * matches that still ran at the end. */
+typedef struct {
+    SigfmImgInfo *id[MAX_TEMPLATE_ENTRIES];
+    int           score[MAX_TEMPLATE_ENTRIES][MAX_TEMPLATE_ENTRIES];
+    int           n;
+    int           enabled;
+    long          early;    /* match calls during presses */
+    long          late;     /* match calls after the last press */
+} PairScores;
+
+static int
+pairs_find(const PairScores *p, const SigfmImgInfo *e)
+{
+    for (int i = 0; i < p->n; i++)
+        if (p->id[i] == e)
+            return i;
+    return -1;
+}
+
+/* Record `info` against every template entry; call before template_add().
+ * Returns the best score of an enrolled frame against it, -1 if none. */
+static int
+pairs_add(PairScores *p, const Template *t, SigfmImgInfo *info)
+{
+    if (!p->enabled || p->n >= MAX_TEMPLATE_ENTRIES)
+        return -1;
+    int ni = p->n++, best = -1;
+    p->id[ni] = info;
+    p->score[ni][ni] = 0;
+    for (int k = 0; k < t->count; k++) {
+        int ki = pairs_find(p, t->entries[k]);
+        if (ki < 0)
+            continue;
+        p->score[ki][ni] = sigfm_match_score(t->entries[k], info);
+        p->score[ni][ki] = sigfm_match_score(info, t->entries[k]);
+        p->early += 2;
+        if (p->score[ki][ni] > best) best = p->score[ki][ni];
+    }
+    return best;
+}
+
+static int
+pair_score(PairScores *p, SigfmImgInfo *a, SigfmImgInfo *b)
+{
+    if (p->enabled) {
+        int ai = pairs_find(p, a), bi = pairs_find(p, b);
+        if (ai >= 0 && bi >= 0)
+            return p->score[ai][bi];
+    }
+    p->late++;
+    return sigfm_match_score(a, b);
+}
+
 /* Quality-ranked enrollment insertion (E4):
  * Once template has min_fill entries, only add a new frame if its keypoint
  * count exceeds the current weakest entry.  If the template is full,
  * replace the weakest entry.  Effect: enrolled sub-templates converge to
  * the highest-quality captures from the enrollment set. */
 static int
-template_add_quality(Template *t, SigfmImgInfo *info, int min_fill)
+template_add_quality(Template *t, SigfmImgInfo *info, const GlobalSig *sig,
+                     int min_fill)
 {
     int kp = sigfm_keypoints_count(info);
 
@@ -158,6 +321,7 @@ template_add_quality(Template *t, SigfmImgInfo *info, int min_fill)
     if (t->count < min_fill) {
         t->entries[t->count] = info;
         t->scores[t->count] = kp;
+        t->sigs[t->count] = *sig;
         t->count++;
         return 0;
     }
@@ -182,12 +346,14 @@ template_add_quality(Template *t, SigfmImgInfo *info, int min_fill)
         /* Still room — just add */
         t->entries[t->count] = info;
         t->scores[t->count] = kp;
+        t->sigs[t->count] = *sig;
         t->count++;
     } else {
         /* Full — replace worst */
         sigfm_free_info(t->entries[worst_idx]);
         t->entries[worst_idx] = info;
         t->scores[worst_idx] = kp;
+        t->sigs[worst_idx] = *sig;
     }
     return 0;
 }
@@ -198,7 +364,7 @@ template_add_quality(Template *t, SigfmImgInfo *info, int min_fill)
  * the target count.  This maximizes placement diversity by eliminating
  * redundant near-duplicate captures. */
 static void
-template_diversity_prune(Template *t, int target_count, FILE *out)
+template_diversity_prune(Template *t, PairScores *pairs, int target_count, FILE *out)
 {
     if (t->count <= target_count) return;
 
@@ -210,7 +376,7 @@ template_diversity_prune(Template *t, int target_count, FILE *out)
         int best_i = 0, best_j = 1, best_s = -1;
         for (int i = 0; i < t->count; i++) {
             for (int j = i + 1; j < t->count; j++) {
-                int s = sigfm_match_score(t->entries[i], t->entries[j]);
+                int s = pair_score(pairs, t->entries[i], t->entries[j]);
                 if (s > best_s) {
                     best_s = s;
                     best_i = i;
@@ -229,6 +395,7 @@ template_diversity_prune(Template *t, int target_count, FILE *out)
         for (int k = remove; k < t->count - 1; k++) {
             t->entries[k] = t->entries[k + 1];
             t->scores[k] = t->scores[k + 1];
+            t->sigs[k] = t->sigs[k + 1];
         }
         t->count--;
     }
@@ -252,9 +419,290 @@ template_match(Template *t, SigfmImgInfo *probe, int *best_idx)
     return best;
 }
 
+/* Signature-ranked match (P1): visit entries in ascending global-signature
+ * distance and stop after top_k entries (0 = visit all).  *best_rank
+ * receives the position in that order at which the returned best score was
+ * first reached, which is what --rank-signature histograms. */
+static int
+template_match_ranked(Template *t, SigfmImgInfo *probe, const GlobalSig *probe_sig,
+                      int top_k, int *best_idx, int *best_rank, int *n_matched)
+{
+    int   order[MAX_TEMPLATE_ENTRIES];
+    float dist[MAX_TEMPLATE_ENTRIES];
+
+    /* Insertion sort — count ≤ MAX_TEMPLATE_ENTRIES, typically 20 */
+    for (int i = 0; i < t->count; i++) {
+        float d = global_sig_dist(&t->sigs[i], probe_sig);
+        int j = i;
+        while (j > 0 && dist[j - 1] > d) {
+            dist[j] = dist[j - 1];
+            order[j] = order[j - 1];
+            j--;
+        }
+        dist[j] = d;
+        order[j] = i;
+    }
+
+    int limit = (top_k > 0 && top_k < t->count) ? top_k : t->count;
+    int best = -1, bidx = -1, brank = -1;
+    for (int r = 0; r < limit; r++) {
+        int score = sigfm_match_score(t->entries[order[r]], probe);
+        if (score > best) {
+            best = score;
+            bidx = order[r];
+            brank = r;
+        }
+    }
+    if (best_idx)  *best_idx = bidx;
+    if (best_rank) *best_rank = brank;
+    if (n_matched) *n_matched = limit;
+    return best;
+}
+
+/* ------------------------------------------------------------------ */
+/* Most-recently-matched order (P17, doc 20 §18)                        */
+/* ------------------------------------------------------------------ */
+
+/* MatchCacheListSwitch: visit sub-templates in the order they last
+ * accepted and stop at the first one that does.  Accept/reject is the same
+ * as the exhaustive loop (any entry >= threshold accepts); only the score
+ * reported for an accept is the first accepting one, not the maximum.
+ * Study replaces entries in place, so indices stay valid. */
+typedef struct {
+    int  order[MAX_TEMPLATE_ENTRIES];
+    int  count;
+    int  pos_hist[3];   /* accepting entry at MRU position 0, 1, >=2 */
+} MruState;
+
+static void
+mru_init(MruState *m, const Template *t)
+{
+    memset(m, 0, sizeof(*m));
+    m->count = t->count;
+    for (int i = 0; i < t->count; i++)
+        m->order[i] = i;
+}
+
+static int
+template_match_mru(Template *t, SigfmImgInfo *probe, MruState *m, int threshold,
+                   int *best_idx, int *n_matched)
+{
+    int best = -1, bidx = -1, n = 0;
+    for (int r = 0; r < m->count; r++) {
+        int idx = m->order[r];
+        int score = sigfm_match_score(t->entries[idx], probe);
+        n++;
+        if (score >= threshold) {
+            memmove(&m->order[1], &m->order[0], r * sizeof(m->order[0]));
+            m->order[0] = idx;
+            m->pos_hist[r < 2 ? r : 2]++;
+            best = score;
+            bidx = idx;
+            break;
+        }
+        if (score > best) {
+            best = score;
+            bidx = idx;
+        }
+    }
+    if (best_idx)  *best_idx = bidx;
+    if (n_matched) *n_matched = n;
+    return best;
+}
+
+/* The sub-template visit order chosen on the command line: exhaustive,
+ * --rank-signature or --mru-order.  Each verify pass keeps its own MRU
+ * state so passes over the same frames compare like with like. */
+typedef struct {
+    int       rank;
+    int       rank_topk;
+    MruState *mru;          /* NULL unless --mru-order */
+    int       threshold;    /* MRU stops at the first accept */
+} VisitOrder;
+
+static int
+template_match_visit(Template *t, SigfmImgInfo *probe, const GlobalSig *sig,
+                     const VisitOrder *vo, int *best_idx, int *best_rank,
+                     int *n_matched)
+{
+    if (best_rank) *best_rank = -1;
+    if (vo->rank)
+        return template_match_ranked(t, probe, sig, vo->rank_topk,
+                                     best_idx, best_rank, n_matched);
+    if (vo->mru)
+        return template_match_mru(t, probe, vo->mru, vo->threshold,
+                                  best_idx, n_matched);
+    if (n_matched) *n_matched = t->count;
+    return template_match(t, probe, best_idx);
+}
+
+/* ------------------------------------------------------------------ */
+/* Burst capture (P22, doc 20 §23)                                      */
+/* ------------------------------------------------------------------ */
+
+/* Several frames per finger-down.  Consecutive verify files stand in for
+ * one burst; each frame goes through the stddev and keypoint gates, and
+ * either the best survivor (most keypoints, then highest stddev) is
+ * matched, or every survivor in capture order until one accepts.  A burst
+ * with no survivor is a RETRY_CENTER_FINGER: a touch that gave no result.
+ *
+ * With frame_ms > 0 each touch is also put on a timeline (P23, doc 20
+ * §24): frame j lands at (j+1)·frame_ms after touch-down and a single
+ * worker runs gates + extraction as frames land.  "Burst" matches once
+ * the last frame is extracted; "speculative" matches each frame right
+ * after its extraction and cancels the rest of the burst on an accept.
+ * Both follow the match-all order, so they reach the same decision.
+ *
+ * Sub-templates are visited in the same order as the single-frame pass
+ * (vo), with a fresh MRU list, so match calls and times compare. */
+#define BURST_MAX  8
+
+typedef struct {
+    int    touches;
+    int    touches_ok;
+    int    touches_gated;
+    int    frames_gated;
+    long   match_calls;
+    double single_ms;       /* touch → result, summed over single_touches */
+    int    single_touches;  /* touches whose first frame passed the gates */
+    double burst_ms;
+    double spec_ms;
+    int    spec_frames;     /* frames captured before speculative cancel */
+} BurstStats;
+
+static void
+burst_verify(Template *t, const char **files, int n, int burst, int match_all,
+             int stddev_gate, int quality_gate, int threshold, int kp_budget,
+             const VisitOrder *order, double frame_ms, BurstStats *bs, FILE *out)
+{
+    MruState mru;
+    VisitOrder vo = *order;
+    if (vo.mru) {
+        mru_init(&mru, t);
+        vo.mru = &mru;
+    }
+
+    memset(bs, 0, sizeof(*bs));
+    fprintf(out, "\nBurst verification: %d frames per touch, %s\n",
+            burst, match_all ? "match all" : "match best");
+
+    for (int b = 0; b < n; b += burst) {
+        int m = n - b < burst ? n - b : burst;
+        SigfmImgInfo *info[BURST_MAX] = { 0 };
+        GlobalSig sig[BURST_MAX];
+        int kp[BURST_MAX] = { 0 }, sd[BURST_MAX] = { 0 };
+        double ex_ms[BURST_MAX] = { 0 }, mt_ms[BURST_MAX] = { 0 };
+        int pick = -1, passed = 0;
+
+        for (int j = 0; j < m; j++) {
+            int w, h;
+            unsigned char *pix = read_pgm(files[b + j], &w, &h);
+            if (!pix)
+                continue;
+            double t0 = now_us();
+            sd[j] = pixel_stddev(pix, w * h);
+            if (sd[j] >= stddev_gate) {
+                if (vo.rank)
+                    global_sig_compute(pix, w, h, &sig[j]);
+                info[j] = extract_frame(pix, w, h, kp_budget);
+            }
+            free(pix);
+            if (info[j]) {
+                kp[j] = sigfm_keypoints_count(info[j]);
+                if (kp[j] < quality_gate) {
+                    sigfm_free_info(info[j]);
+                    info[j] = NULL;
+                }
+            }
+            ex_ms[j] = (now_us() - t0) / 1000;
+            if (!info[j]) {
+                bs->frames_gated++;
+                continue;
+            }
+            passed++;
+            if (pick < 0 || kp[j] > kp[pick] || (kp[j] == kp[pick] && sd[j] > sd[pick]))
+                pick = j;
+        }
+
+        bs->touches++;
+        int score = -1, used = pick, last = m - 1;
+        if (pick < 0) {
+            bs->touches_gated++;
+            fprintf(out, "  [T%02d] GATED (0 of %d frames passed): %s\n",
+                    b / burst, m, files[b]);
+        } else if (match_all) {
+            for (int j = 0; j < m && score < threshold; j++) {
+                if (!info[j])
+                    continue;
+                int calls;
+                double t0 = now_us();
+                int s = template_match_visit(t, info[j], &sig[j], &vo, NULL, NULL, &calls);
+                mt_ms[j] = (now_us() - t0) / 1000;
+                bs->match_calls += calls;
+                last = j;
+                if (s > score) {
+                    score = s;
+                    used = j;
+                }
+            }
+        } else {
+            int calls;
+            double t0 = now_us();
+            score = template_match_visit(t, info[pick], &sig[pick], &vo, NULL, NULL, &calls);
+            mt_ms[pick] = (now_us() - t0) / 1000;
+            bs->match_calls += calls;
+        }
+
+        if (frame_ms > 0) {
+            /* Single frame: frame 0 alone, which the match-all order
+             * matched first.  A gated frame 0 gives that touch no result,
+             * so it is left out of the single-frame mean */
+            if (info[0]) {
+                bs->single_ms += frame_ms + ex_ms[0] + mt_ms[0];
+                bs->single_touches++;
+            }
+
+            /* Speculative stops at an accept; without one it captures,
+             * gates and matches the whole burst like the burst mode */
+            int accepted = score >= threshold;
+            double worker = 0, spec = 0, matched = 0;
+            int spec_done = 0;
+            for (int j = 0; j < m; j++) {
+                double arrive = (j + 1) * frame_ms;
+                worker = (worker > arrive ? worker : arrive) + ex_ms[j];
+                if (!spec_done) {
+                    spec = (spec > arrive ? spec : arrive) + ex_ms[j] + mt_ms[j];
+                    bs->spec_frames++;
+                    spec_done = accepted && j == last;
+                }
+                matched += mt_ms[j];
+            }
+            bs->burst_ms += worker + matched;
+            bs->spec_ms += spec;
+            /* Frames landed by the accept, plus the one in flight: a TLS
+             * record cannot be abandoned mid-transfer, so it is drained */
+            int landed = (int)(spec / frame_ms) + 1;
+            if (landed > m) landed = m;
+            if (spec_done && landed > last + 1)
+                bs->spec_frames += landed - (last + 1);
+        }
+
+        if (pick < 0)
+            continue;
+        bs->touches_ok += score >= threshold;
+        fprintf(out, "  [T%02d] %s score=%d/%d frame %d of %d (kp=%d, %d passed): %s\n",
+                b / burst, score >= threshold ? "MATCH" : "FAIL ", score, threshold,
+                used + 1, m, kp[used], passed, files[b + used]);
+
+        for (int j = 0; j < m; j++)
+            if (info[j])
+                sigfm_free_info(info[j]);
+    }
+}
+
 /* Template study: replace weakest entry if probe is better */
 static int
-template_study(Template *t, SigfmImgInfo *probe)
+template_study(Template *t, SigfmImgInfo *probe, const GlobalSig *probe_sig)
 {
     if (t->count < 2) return 0;
 
@@ -291,6 +739,7 @@ template_study(Template *t, SigfmImgInfo *probe)
         sigfm_free_info(t->entries[worst_idx]);
         t->entries[worst_idx] = sigfm_copy_info(probe);
         t->scores[worst_idx] = probe_avg;
+        t->sigs[worst_idx] = *probe_sig;
         return 1; /* updated */
     }
     return 0; /* no update */
@@ -338,7 +787,8 @@ study_record_hit(StudyState *s, int best_idx)
 
 /* Windows-style template study with multi-layer protection */
 static int
-template_study_v2(Template *t, SigfmImgInfo *probe, StudyState *state)
+template_study_v2(Template *t, SigfmImgInfo *probe, const GlobalSig *probe_sig,
+                  StudyState *state)
 {
     if (t->count < 2) return 0;
 
@@ -437,6 +887,7 @@ template_study_v2(Template *t, SigfmImgInfo *probe, StudyState *state)
     sigfm_free_info(t->entries[target_idx]);
     t->entries[target_idx] = sigfm_copy_info(probe);
     t->scores[target_idx] = probe_avg;
+    t->sigs[target_idx] = *probe_sig;
     state->kp_counts[target_idx] = probe_kp;
     state->hit_counts[target_idx] = 0;  /* reset hit count for new entry */
     state->failed_updates = 0;          /* reset degradation counter on success */
@@ -463,6 +914,36 @@ usage(const char *argv0)
         "          [--progressive-enroll] two-pass enrollment: strict then lenient (E6)\n"
         "          [--progressive-strict=N] keypoint threshold for strict phase (default: 15)\n"
         "          [--max-subtemplates=N] max enrolled frames to keep (default: 20)\n"
+        "          [--rank-signature]     visit sub-templates by global-signature distance,\n"
+        "                                 report rank of the best match (P1)\n"
+        "          [--rank-topk=K]        match only the K closest sub-templates (implies\n"
+        "                                 --rank-signature)\n"
+        "          [--kp-budget=N]        keep only the N strongest keypoints per frame (P6,\n"
+        "                                 needs sigfm_extract_budget(); default: MAX_KP)\n"
+        "          [--match-retry=N]      in-driver retry (P16): up to N re-captures per touch\n"
+        "                                 after a failed match; consecutive verify frames\n"
+        "                                 form one touch\n"
+        "          [--retry-budget-ms=M]  stop retrying once the added latency would pass M ms\n"
+        "                                 (default: no limit)\n"
+        "          [--retry-capture-ms=C] capture cost per retry, added to the measured\n"
+        "                                 extract + match time (default: 0)\n"
+        "          [--mru-order]          visit sub-templates most-recently-matched first and\n"
+        "                                 stop at the first accept (P17)\n"
+        "          [--adaptive-enroll=N]  stop enrolling after N consecutive presses that add\n"
+        "                                 no coverage (P20); --max-subtemplates is the cap\n"
+        "          [--enroll-min=M]       never stop before M enrolled frames (default: 8)\n"
+        "          [--novelty-score=S]    a press scoring >= S against an enrolled frame adds\n"
+        "                                 no coverage (default: --score-threshold)\n"
+        "          [--incremental-pairs]  match each enrolled frame against the earlier ones as\n"
+        "                                 it is added; sorting and pruning read the cache (P21)\n"
+        "          [--press-interval-ms=I] model enrollment with I ms between presses: serial\n"
+        "                                 vs pipelined total and time after the last press\n"
+        "          [--burst=K]            also verify with K consecutive frames per touch (P22)\n"
+        "          [--burst-select=MODE]  best: match the best gated frame (default);\n"
+        "                                 all: match each until one accepts\n"
+        "          [--burst-frame-ms=F]   frames land F ms apart: touch-to-result time for one\n"
+        "                                 frame, burst and speculative matching (P23; needs\n"
+        "                                 --burst-select=all)\n"
         "\n"
         "Reads processed PGM images (64×80, as output by img-capture or replay-pipeline),\n"
         "enrolls from the first set, verifies against the second, and reports FRR.\n"
@@ -499,6 +980,21 @@ main(int argc, char *argv[])
     int do_progressive_enroll = 0;
     int progressive_strict = 15;
     int max_subtemplates = 20;
+    int do_rank = 0;
+    int rank_topk = 0;  /* 0 = visit all sub-templates in ranked order */
+    int kp_budget = 0;  /* 0 = sigfm.c MAX_KP */
+    int match_retry = 0;            /* retries per touch, 0 = one attempt (fprintd loop) */
+    double retry_budget_ms = 0;     /* 0 = no time limit */
+    double retry_capture_ms = 0;
+    int do_mru = 0;
+    int adaptive_n = 0;             /* 0 = fixed-length enrollment */
+    int enroll_min = 8;
+    int novelty_score = -1;         /* -1 = score_threshold */
+    int do_incremental_pairs = 0;
+    double press_interval_ms = 0;   /* 0 = no enrollment timeline */
+    int burst = 0;                  /* 0 = no burst pass */
+    int burst_all = 0;
+    double burst_frame_ms = 0;      /* 0 = no touch-to-result timeline */
 
     enum { NONE, ENROLL, VERIFY } mode = NONE;
 
@@ -536,6 +1032,46 @@ main(int argc, char *argv[])
             do_progressive_enroll = 1;
         } else if (strncmp(argv[i], "--max-subtemplates=", 19) == 0) {
             max_subtemplates = atoi(argv[i] + 19);
+        } else if (strcmp(argv[i], "--rank-signature") == 0) {
+            do_rank = 1;
+        } else if (strncmp(argv[i], "--rank-topk=", 12) == 0) {
+            rank_topk = atoi(argv[i] + 12);
+            do_rank = 1;
+        } else if (strncmp(argv[i], "--kp-budget=", 12) == 0) {
+            kp_budget = atoi(argv[i] + 12);
+#ifndef SIGFM_HAVE_KP_BUDGET
+            if (kp_budget > 0) {
+                fprintf(stderr, "--kp-budget needs a sigfm.h with sigfm_extract_budget()\n");
+                return 1;
+            }
+#endif
+        } else if (strncmp(argv[i], "--match-retry=", 14) == 0) {
+            match_retry = atoi(argv[i] + 14);
+        } else if (strncmp(argv[i], "--retry-budget-ms=", 18) == 0) {
+            retry_budget_ms = atof(argv[i] + 18);
+        } else if (strncmp(argv[i], "--retry-capture-ms=", 19) == 0) {
+            retry_capture_ms = atof(argv[i] + 19);
+        } else if (strcmp(argv[i], "--mru-order") == 0) {
+            do_mru = 1;
+        } else if (strncmp(argv[i], "--adaptive-enroll=", 18) == 0) {
+            adaptive_n = atoi(argv[i] + 18);
+        } else if (strncmp(argv[i], "--enroll-min=", 13) == 0) {
+            enroll_min = atoi(argv[i] + 13);
+        } else if (strncmp(argv[i], "--novelty-score=", 16) == 0) {
+            novelty_score = atoi(argv[i] + 16);
+        } else if (strcmp(argv[i], "--incremental-pairs") == 0) {
+            do_incremental_pairs = 1;
+        } else if (strncmp(argv[i], "--press-interval-ms=", 20) == 0) {
+            press_interval_ms = atof(argv[i] + 20);
+        } else if (strncmp(argv[i], "--burst=", 8) == 0) {
+            burst = atoi(argv[i] + 8);
+        } else if (strncmp(argv[i], "--burst-select=", 15) == 0) {
+            if (strcmp(argv[i] + 15, "all") == 0)
+                burst_all = 1;
+            else if (strcmp(argv[i] + 15, "best") != 0)
+                usage(argv[0]);
+        } else if (strncmp(argv[i], "--burst-frame-ms=", 17) == 0) {
+            burst_frame_ms = atof(argv[i] + 17);
         } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
             usage(argv[0]);
         } else if (argv[i][0] == '-') {
@@ -558,6 +1094,40 @@ main(int argc, char *argv[])
         usage(argv[0]);
     }
 
+    if (do_mru && do_rank) {
+        fprintf(stderr, "--mru-order and --rank-signature choose the visit order; use one\n");
+        usage(argv[0]);
+    }
+
+    if (adaptive_n > 0 && (do_quality_enroll || do_progressive_enroll)) {
+        fprintf(stderr, "--adaptive-enroll decides which presses to take; it does not combine\n"
+                        "with --quality-enroll or --progressive-enroll\n");
+        usage(argv[0]);
+    }
+    if (novelty_score < 0)
+        novelty_score = score_threshold;
+
+    if (burst < 0 || burst > BURST_MAX) {
+        fprintf(stderr, "--burst takes 1..%d frames per touch\n", BURST_MAX);
+        usage(argv[0]);
+    }
+    if (burst_frame_ms > 0 && (burst == 0 || !burst_all)) {
+        fprintf(stderr, "--burst-frame-ms times speculative matching, which matches in\n"
+                        "capture order: it needs --burst=K and --burst-select=all\n");
+        usage(argv[0]);
+    }
+    if (burst > 0 && do_template_study) {
+        fprintf(stderr, "--burst re-verifies against the enrolled template; template\n"
+                        "study would change it between the two passes\n");
+        usage(argv[0]);
+    }
+
+    if (do_incremental_pairs && do_quality_enroll) {
+        fprintf(stderr, "--quality-enroll replaces and frees entries during enrollment;\n"
+                        "--incremental-pairs does not track that\n");
+        usage(argv[0]);
+    }
+
     /* Resolve study_threshold — default to score_threshold if not set */
     if (study_threshold < 0)
         study_threshold = score_threshold;
@@ -586,16 +1156,29 @@ main(int argc, char *argv[])
      * but not progressive_strict threshold.  After the strict phase,
      * deferred frames fill remaining template slots to add diversity. */
     SigfmImgInfo *deferred_info[512];
+    GlobalSig deferred_sig[512];
     int deferred_kp[512];
     int n_deferred = 0;
     int progressive_core = max_subtemplates / 2;
 
+    /* Adaptive enrollment (P20): presses read, run of presses that added
+     * no coverage, presses that did */
+    int presses = n_enroll, stale_run = 0, novel_presses = 0;
+
+    /* Incremental pair scores and per-press timing (P21).  press_t[i] is
+     * when press i's processing started; the next press's start (or the
+     * loop exit) is when it ended. */
+    static PairScores pairs;
+    pairs.enabled = do_incremental_pairs;
+    double press_t[513];
+
     if (do_progressive_enroll) {
         fprintf(out, "  Progressive enrollment: strict=%d (core: %d slots), lenient=%d\n",
                progressive_strict, progressive_core, quality_gate);
     }
 
     for (int i = 0; i < n_enroll; i++) {
+        press_t[i] = now_us();
         int w, h;
         unsigned char *pix = read_pgm(enroll_files[i], &w, &h);
         if (!pix) {
@@ -615,7 +1198,12 @@ main(int argc, char *argv[])
             continue;
         }
 
-        SigfmImgInfo *info = sigfm_extract(pix, w, h);
+        /* Only --rank-signature reads it; keep it off the baseline timings */
+        GlobalSig sig = { 0 };
+        if (do_rank)
+            global_sig_compute(pix, w, h, &sig);
+
+        SigfmImgInfo *info = extract_frame(pix, w, h, kp_budget);
         free(pix);
 
         if (!info) {
@@ -642,6 +1230,7 @@ main(int argc, char *argv[])
             if (kp < progressive_strict) {
                 /* Passes normal gate but not strict — defer to lenient phase */
                 deferred_info[n_deferred] = info;
+                deferred_sig[n_deferred] = sig;
                 deferred_kp[n_deferred] = kp;
                 n_deferred++;
                 fprintf(out, "  [%02d] DEFER  (keypoints %d < %d, strict phase): %s\n",
@@ -650,8 +1239,36 @@ main(int argc, char *argv[])
             }
         }
 
+        /* Adaptive enrollment (P20): register the press against every
+         * accepted frame with the matcher.  The score API gives no
+         * transform, so "adds coverage" is approximated by "no accepted
+         * frame already explains it" — best score below novelty_score. */
+        if (adaptive_n > 0) {
+            int best = -1;
+            if (pairs.enabled) {
+                best = pairs_add(&pairs, &tmpl, info);
+            } else {
+                for (int k = 0; k < tmpl.count; k++) {
+                    int sc = sigfm_match_score(tmpl.entries[k], info);
+                    if (sc > best) best = sc;
+                }
+            }
+            int novel = best < novelty_score;
+            novel_presses += novel;
+            stale_run = novel ? 0 : stale_run + 1;
+            template_add(&tmpl, info, &sig);
+            fprintf(out, "  [%02d] OK     (keypoints: %d, best %d vs enrolled, %s): %s\n",
+                   i, kp, best, novel ? "new coverage" : "covered", enroll_files[i]);
+            if ((tmpl.count >= enroll_min && stale_run >= adaptive_n) ||
+                tmpl.count >= max_subtemplates) {
+                presses = i + 1;
+                break;
+            }
+            continue;
+        }
+
         if (do_quality_enroll) {
-            int rc = template_add_quality(&tmpl, info, max_subtemplates / 2);
+            int rc = template_add_quality(&tmpl, info, &sig, max_subtemplates / 2);
             if (rc < 0) {
                 fprintf(out, "  [%02d] SKIP   (quality rank %d ≤ worst): %s\n",
                        i, kp, enroll_files[i]);
@@ -661,10 +1278,12 @@ main(int argc, char *argv[])
                        i, kp, enroll_files[i]);
             }
         } else {
-            template_add(&tmpl, info);
+            pairs_add(&pairs, &tmpl, info);
+            template_add(&tmpl, info, &sig);
             fprintf(out, "  [%02d] OK     (keypoints: %d): %s\n", i, kp, enroll_files[i]);
         }
     }
+    press_t[presses] = now_us();
 
     /* Progressive enrollment (E6): lenient phase — add deferred frames */
     if (do_progressive_enroll && n_deferred > 0) {
@@ -676,7 +1295,8 @@ main(int argc, char *argv[])
                 sigfm_free_info(deferred_info[i]);
                 continue;
             }
-            template_add(&tmpl, deferred_info[i]);
+            pairs_add(&pairs, &tmpl, deferred_info[i]);
+            template_add(&tmpl, deferred_info[i], &deferred_sig[i]);
             fprintf(out, "  [D%02d] OK     (keypoints: %d, lenient phase)\n",
                    i, deferred_kp[i]);
             added++;
@@ -687,10 +1307,15 @@ main(int argc, char *argv[])
     int enrolled = tmpl.count;
     fprintf(out, "\n  Enrolled: %d/%d (rejected: %d, stddev-rejected: %d)\n",
            enrolled, n_enroll, enroll_rejected, enroll_stddev_rejected);
+    if (adaptive_n > 0)
+        fprintf(out, "  Adaptive: %d presses of %d (%d saved), %d added coverage, "
+               "stop after %d covered in a row, bounds [%d, %d]\n",
+               presses, n_enroll, n_enroll - presses, novel_presses,
+               adaptive_n, enroll_min, max_subtemplates);
     if (enrolled > 0) {
         fprintf(out, "  Keypoints: min=%d max=%d mean=%ld\n",
                enroll_kp_min, enroll_kp_max,
-               enroll_kp_total / (n_enroll - enroll_rejected > 0 ? n_enroll - enroll_rejected : 1));
+               enroll_kp_total / (presses - enroll_rejected > 0 ? presses - enroll_rejected : 1));
     }
 
     if (enrolled == 0) {
@@ -709,7 +1334,7 @@ main(int argc, char *argv[])
             long total = 0;
             for (int j = 0; j < tmpl.count; j++) {
                 if (i == j) continue;
-                int s = sigfm_match_score(tmpl.entries[i], tmpl.entries[j]);
+                int s = pair_score(&pairs, tmpl.entries[i], tmpl.entries[j]);
                 if (s < 0) s = 0;
                 total += s;
             }
@@ -726,6 +1351,9 @@ main(int argc, char *argv[])
                     int tmp_s = tmpl.scores[i];
                     tmpl.scores[i] = tmpl.scores[j];
                     tmpl.scores[j] = tmp_s;
+                    GlobalSig tmp_g = tmpl.sigs[i];
+                    tmpl.sigs[i] = tmpl.sigs[j];
+                    tmpl.sigs[j] = tmp_g;
                 }
             }
         }
@@ -741,7 +1369,41 @@ main(int argc, char *argv[])
 
     /* Diversity pruning: remove most-similar pairs until target count */
     if (do_diversity_prune && tmpl.count > max_subtemplates) {
-        template_diversity_prune(&tmpl, max_subtemplates, out);
+        template_diversity_prune(&tmpl, &pairs, max_subtemplates, out);
+    }
+
+    /* Enrollment timeline (P21): the driver sees each press's processing
+     * between finger-off and re-arm, and the final build after the last
+     * press.  Serial: the next press waits for the previous one's
+     * processing.  Pipelined: press k is processed on a worker while
+     * press k+1 is awaited, so only a backlog or the final build remains
+     * after the last press. */
+    double build_us = now_us() - press_t[presses];
+    double press_sum = 0, press_max = 0;
+    for (int i = 0; i < presses; i++) {
+        double p = press_t[i + 1] - press_t[i];
+        press_sum += p;
+        if (p > press_max) press_max = p;
+    }
+    fprintf(out, "\n  Enroll timing: %.1f ms/press (max %.1f), final build %.1f ms, "
+           "pair matches %ld with each frame + %ld at the end\n",
+           press_sum / presses / 1000, press_max / 1000, build_us / 1000,
+           pairs.early, pairs.late);
+    if (press_interval_ms > 0) {
+        double gap = press_interval_ms * 1000;
+        double serial = 0, worker = 0;
+        for (int i = 0; i < presses; i++) {
+            double p = press_t[i + 1] - press_t[i];
+            serial += gap + p;
+            double arrive = (i + 1) * gap;
+            worker = (worker > arrive ? worker : arrive) + p;
+        }
+        double last_serial = press_t[presses] - press_t[presses - 1] + build_us;
+        double last_piped = worker - presses * gap + build_us;
+        fprintf(out, "  Timeline @ %.0f ms/press: serial %.1f s, pipelined %.1f s; "
+               "after last press: serial %.1f ms, pipelined %.1f ms\n",
+               press_interval_ms, (serial + build_us) / 1e6,
+               (worker + build_us) / 1e6, last_serial / 1000, last_piped / 1000);
     }
 
     /* ── Verification ───────────────────────────────────────────── */
@@ -761,12 +1423,30 @@ main(int argc, char *argv[])
     long score_total = 0;
     int score_min = 999999, score_max = -1;
     int template_updates = 0;
+    int rank_hist[4] = { 0 };  /* best match at rank 0, 1, 2, ≥3 */
+    long match_calls = 0;
+    double extract_us = 0, match_us = 0;
+    int extract_frames = 0;
+
+    /* In-driver match retry (P16): a touch is the first counted attempt plus
+     * up to match_retry re-captures, ending at the first match.  Gated
+     * frames are re-captured by the driver anyway and do not count. */
+    int touches = 0, touches_ok = 0, touch_attempt = 0, touch_matched = 0;
+    int retries = 0, rescued = 0;
+    double touch_added_ms = 0, retry_ms = 0;
 
     /* Study v2 state — persists across all verify iterations */
     StudyState study_state;
     if (do_study_v2)
         study_state_init(&study_state, &tmpl);
 
+    MruState mru;
+    mru_init(&mru, &tmpl);
+    VisitOrder visit = {
+        .rank = do_rank, .rank_topk = rank_topk,
+        .mru = do_mru ? &mru : NULL, .threshold = score_threshold,
+    };
+
     for (int i = 0; i < n_verify; i++) {
         int w, h;
         unsigned char *pix = read_pgm(verify_files[i], &w, &h);
@@ -790,7 +1470,16 @@ main(int argc, char *argv[])
             continue;
         }
 
-        SigfmImgInfo *info = sigfm_extract(pix, w, h);
+        /* Only --rank-signature reads it; keep it off the baseline timings */
+        GlobalSig sig = { 0 };
+        if (do_rank)
+            global_sig_compute(pix, w, h, &sig);
+
+        double t_extract = now_us();
+        SigfmImgInfo *info = extract_frame(pix, w, h, kp_budget);
+        double frame_us = now_us() - t_extract;
+        extract_us += frame_us;
+        extract_frames++;
         free(pix);
 
         if (!info) {
@@ -815,8 +1504,15 @@ main(int argc, char *argv[])
             continue;
         }
 
-        int best_idx;
-        int score = template_match(&tmpl, info, &best_idx);
+        int best_idx, best_rank, n_matched;
+        double t_match = now_us();
+        int score = template_match_visit(&tmpl, info, &sig, &visit,
+                                         &best_idx, &best_rank, &n_matched);
+        match_calls += n_matched;
+        if (do_rank && score >= score_threshold && best_rank >= 0)
+            rank_hist[best_rank < 3 ? best_rank : 3]++;
+        match_us += now_us() - t_match;
+        frame_us += now_us() - t_match;
 
         if (score < 0) {
             fprintf(out, "  [%02d] ERROR (match error): %s\n", i, verify_files[i]);
@@ -827,6 +1523,32 @@ main(int argc, char *argv[])
             continue;
         }
 
+        if (match_retry > 0) {
+            double cost_ms = retry_capture_ms + frame_us / 1000.0;
+            if (touch_attempt > 0) {
+                touch_added_ms += cost_ms;
+                retries++;
+                retry_ms += cost_ms;
+                fprintf(out, "  [%02d] retry %d of touch %d (+%.1f ms, %.1f ms added)\n",
+                       i, touch_attempt, touches + 1, cost_ms, touch_added_ms);
+            }
+            touch_attempt++;
+            if (score >= score_threshold) {
+                touch_matched = 1;
+                if (touch_attempt > 1)
+                    rescued++;
+            }
+            /* MatchRetryMaxCount / MatchRetryMaxTime: the next retry must
+             * fit in the budget, estimated from this attempt's cost */
+            if (touch_matched || touch_attempt > match_retry ||
+                (retry_budget_ms > 0 && touch_added_ms + cost_ms > retry_budget_ms)) {
+                touches++;
+                touches_ok += touch_matched;
+                touch_attempt = touch_matched = 0;
+                touch_added_ms = 0;
+            }
+        }
+
         if (score < score_min) score_min = score;
         if (score > score_max) score_max = score;
         score_total += score;
@@ -848,9 +1570,9 @@ main(int argc, char *argv[])
             if (do_template_study && score >= study_threshold) {
                 int updated;
                 if (do_study_v2)
-                    updated = template_study_v2(&tmpl, info, &study_state);
+                    updated = template_study_v2(&tmpl, info, &sig, &study_state);
                 else
-                    updated = template_study(&tmpl, info);
+                    updated = template_study(&tmpl, info, &sig);
                 if (updated) {
                     template_updates++;
                     study_updated = 1;
@@ -877,6 +1599,18 @@ main(int argc, char *argv[])
         sigfm_free_info(info);
     }
 
+    /* A touch cut short by the end of the verify set still counts */
+    if (touch_attempt > 0) {
+        touches++;
+        touches_ok += touch_matched;
+    }
+
+    BurstStats bs;
+    if (burst > 0)
+        burst_verify(&tmpl, verify_files, n_verify, burst, burst_all, stddev_gate,
+                     quality_gate, score_threshold, kp_budget, &visit, burst_frame_ms,
+                     &bs, out);
+
     /* ── Summary ────────────────────────────────────────────────── */
 
     int total_attempts = match_ok + match_fail;
@@ -896,12 +1630,78 @@ main(int argc, char *argv[])
         fprintf(out, "  Score: min=%d max=%d mean=%ld\n",
                score_min, score_max, score_total / total_attempts);
     }
+    if (match_retry > 0 && touches > 0) {
+        fprintf(out, "  Match retry:       up to %d per touch", match_retry);
+        if (retry_budget_ms > 0)
+            fprintf(out, ", budget %.0f ms", retry_budget_ms);
+        fprintf(out, ", capture %.0f ms per retry\n", retry_capture_ms);
+        fprintf(out, "  Per-touch FRR:     %.1f%% (%d of %d touches rejected, %d rescued by a retry)\n",
+               100.0 * (touches - touches_ok) / touches, touches - touches_ok, touches, rescued);
+        if (retries > 0)
+            fprintf(out, "  Retries:           %d, %.1f ms added per retry\n",
+                   retries, retry_ms / retries);
+    }
+    if (burst > 0 && bs.touches > 0) {
+        /* Every single frame above was its own touch, gated ones included:
+         * the driver answers those with RETRY_CENTER_FINGER */
+        int single = total_attempts + verify_gated;
+        fprintf(out, "  Burst:             %d frames per touch, %s, %d touches "
+               "(%d gated, %d of %d frames gated)\n",
+               burst, burst_all ? "match all" : "match best", bs.touches,
+               bs.touches_gated, bs.frames_gated, n_verify);
+        fprintf(out, "  Burst FRR:         %.1f%% per touch with a result\n",
+               bs.touches > bs.touches_gated
+                   ? 100.0 * (bs.touches - bs.touches_gated - bs.touches_ok)
+                     / (bs.touches - bs.touches_gated) : 0.0);
+        fprintf(out, "  Touches per match: burst %.2f, single frame %.2f "
+               "(match calls per touch %.1f vs %.1f)\n",
+               bs.touches_ok ? (double)bs.touches / bs.touches_ok : 0.0,
+               match_ok ? (double)single / match_ok : 0.0,
+               (double)bs.match_calls / bs.touches,
+               single ? (double)match_calls / single : 0.0);
+        if (burst_frame_ms > 0)
+            fprintf(out, "  Touch→result:      one frame %.1f ms (%d touches with a "
+                   "passing first frame), burst %.1f ms, speculative %.1f ms "
+                   "(%.1f of %d frames captured, %.0f ms apart)\n",
+                   bs.single_touches ? bs.single_ms / bs.single_touches : 0.0,
+                   bs.single_touches, bs.burst_ms / bs.touches,
+                   bs.spec_ms / bs.touches, (double)bs.spec_frames / bs.touches,
+                   burst, burst_frame_ms);
+    }
     if (do_template_study)
         fprintf(out, "  Template updates:  %d%s\n", template_updates,
                do_study_v2 ? " (v2/windows-style)" : " (naive)");
     if (study_threshold != score_threshold)
         fprintf(out, "  Study threshold:   %d (match threshold: %d)\n",
                study_threshold, score_threshold);
+    if (total_attempts > 0)
+        fprintf(out, "  Match calls:       %ld (%.1f per attempt, %d sub-templates)\n",
+               match_calls, (double)match_calls / total_attempts, tmpl.count);
+    if (extract_frames > 0 && match_calls > 0)
+        fprintf(out, "  Verify timing:     extract %.0f us/frame, match %.0f us/call\n",
+               extract_us / extract_frames, match_us / match_calls);
+    if (kp_budget > 0)
+        fprintf(out, "  Keypoint budget:   %d\n", kp_budget);
+    if (do_rank && match_ok > 0) {
+        /* Rank of the accepting sub-template in signature order.  With
+         * --rank-topk=0 every entry is visited, so this is the exact
+         * "best match in top-N" rate; with a cap it is conditional on
+         * the match having been found. */
+        int top1 = rank_hist[0];
+        int top3 = rank_hist[0] + rank_hist[1] + rank_hist[2];
+        fprintf(out, "  Signature rank:    top-1 %.1f%%, top-3 %.1f%% of %d matches%s\n",
+               100.0 * top1 / match_ok, 100.0 * top3 / match_ok, match_ok,
+               rank_topk > 0 ? " (capped)" : "");
+        if (rank_topk > 0)
+            fprintf(out, "  Rank cap:          top-%d of %d sub-templates\n",
+                   rank_topk, tmpl.count);
+    }
+    if (do_mru && match_ok > 0) {
+        /* Hit = the accepting sub-template was the one that accepted last */
+        fprintf(out, "  MRU order:         hit %.1f%%, top-2 %.1f%% of %d matches\n",
+               100.0 * mru.pos_hist[0] / match_ok,
+               100.0 * (mru.pos_hist[0] + mru.pos_hist[1]) / match_ok, match_ok);
+    }
     fprintf(out, "═══════════════════════════════════════════\n");
 
     template_free(&tmpl);
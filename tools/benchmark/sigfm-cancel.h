@@ -0,0 +1,92 @@
+/*
+ * sigfm-cancel.h — Cancellation token and deadline for SIGFM matching (P24, doc 20 §25)
+ *
+ * sigfm_match_score() and the driver's sub-template loop run to the end
+ * even after fprintd cancels the operation or the finger is lifted.  A
+ * SigfmCancel is shared by everything working for one operation; the loops
+ * poll it through a per-call SigfmCancelPoll at bounded intervals (a KNN
+ * row, a RANSAC iteration, a sub-template) and stop with the best result
+ * so far when it fires.
+ *
+ * sigfm_cancel_request() may be called from any thread — the driver calls
+ * it from its GCancellable "cancelled" handler — and only sets an atomic
+ * flag.  The poll reads that flag with a relaxed load and, when a deadline
+ * is set, the monotonic clock; `stride` polls share one check so the
+ * clock read stays off the innermost loops' cost.
+ *
+ * Header-only, C11 + stdatomic, no GLib: the same file is copied next to
+ * the fork's sigfm.c and used by tools/.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef SIGFM_CANCEL_H
+#define SIGFM_CANCEL_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Why a bounded call stopped early; 0 = it ran to the end */
+#define SIGFM_STOP_CANCELLED    1
+#define SIGFM_STOP_DEADLINE     2
+
+typedef struct {
+    atomic_int  cancelled;
+    int64_t     deadline_us;    /* CLOCK_MONOTONIC µs, 0 = none */
+} SigfmCancel;
+
+/* One per call (per thread): the countdown is not shared */
+typedef struct {
+    const SigfmCancel *c;
+    unsigned           stride;
+    unsigned           left;
+    int                why;     /* sticky once set */
+} SigfmCancelPoll;
+
+static inline int64_t
+sigfm_cancel_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static inline void
+sigfm_cancel_init(SigfmCancel *c, int64_t deadline_us)
+{
+    atomic_init(&c->cancelled, 0);
+    c->deadline_us = deadline_us;
+}
+
+static inline void
+sigfm_cancel_request(SigfmCancel *c)
+{
+    atomic_store_explicit(&c->cancelled, 1, memory_order_relaxed);
+}
+
+/* c may be NULL: the poll then never fires and costs one branch */
+static inline void
+sigfm_cancel_poll_init(SigfmCancelPoll *p, const SigfmCancel *c, unsigned stride)
+{
+    p->c = c;
+    p->stride = stride ? stride : 1;
+    p->left = 1;                /* first poll checks */
+    p->why = 0;
+}
+
+/* Nonzero (SIGFM_STOP_*) once the caller should stop */
+static inline int
+sigfm_cancel_poll(SigfmCancelPoll *p)
+{
+    if (p->why || !p->c || --p->left)
+        return p->why;
+    p->left = p->stride;
+    if (atomic_load_explicit(&p->c->cancelled, memory_order_relaxed))
+        p->why = SIGFM_STOP_CANCELLED;
+    else if (p->c->deadline_us && sigfm_cancel_now_us() >= p->c->deadline_us)
+        p->why = SIGFM_STOP_DEADLINE;
+    return p->why;
+}
+
+#endif /* SIGFM_CANCEL_H */
@@ -0,0 +1,19 @@
+/*
+ * sigfm-defaults.h — Operating point shared by the SIGFM benchmarks
+ *
+ * The match score threshold every tool defaults to, so that sigfm-batch,
+ * identify-bench and cancel-bench report accepts at the same point.  It
+ * is the Phase 12 operating point, the driver's score_threshold
+ * (goodix511.c): 7 with multi-scale and ratio 0.80 gives FRR 27.6%,
+ * FAR 0.00% cross-corpus (doc 15 §10–§11).  8 is the security-critical
+ * alternative; 6, the earlier value, let FAR reach 2.91%.
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef SIGFM_DEFAULTS_H
+#define SIGFM_DEFAULTS_H
+
+#define SIGFM_SCORE_THRESHOLD   7
+
+#endif /* SIGFM_DEFAULTS_H */
@@ -0,0 +1,313 @@
+/*
+ * sigfm-stress.c — Multi-threaded SIGFM reentrancy stress test (P7, doc 20 §8)
+ *
+ * Runs sigfm_extract() and sigfm_match_score() on every frame from N
+ * threads at once and compares every keypoint count and score against a
+ * single-threaded golden run.  Each thread extracts its own copy of every
+ * frame and matches it against
+ *
+ *   - its own extractions of the next K frames (thread-private infos), and
+ *   - the golden infos of the same frames (shared, read-only — like an
+ *     enrolled gallery that several verify/identify workers read at once).
+ *
+ * Threads walk the work list from different offsets so the same frame is in
+ * flight on several threads simultaneously.  Any difference from the golden
+ * run is a reentrancy bug (shared scratch, shared RNG, lazy globals) and
+ * makes the tool exit non-zero.  Build the -tsan variant (see Makefile) to
+ * have ThreadSanitizer report the race itself.
+ *
+ * Usage:
+ *   sigfm-stress [--threads=N] [--rounds=N] [--pairs=K] f1.pgm f2.pgm ...
+ *
+ * Build:  see Makefile
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sigfm.h"
+
+/* ------------------------------------------------------------------ */
+/* Defaults                                                            */
+/* ------------------------------------------------------------------ */
+
+#define DEFAULT_THREADS     4
+#define DEFAULT_ROUNDS      3
+#define DEFAULT_PAIRS       8       /* frames each frame is matched against */
+#define MAX_FRAMES          4096
+#define MAX_THREADS         64
+
+/* ------------------------------------------------------------------ */
+/* PGM reader (binary P5) — same as sigfm-batch.c                      */
+/* ------------------------------------------------------------------ */
+
+static unsigned char *
+read_pgm(const char *path, int *out_w, int *out_h)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return NULL; }
+
+    char magic[3];
+    if (fscanf(f, "%2s", magic) != 1 || strcmp(magic, "P5") != 0) {
+        fprintf(stderr, "Not a binary PGM (P5): %s\n", path);
+        fclose(f); return NULL;
+    }
+
+    int c;
+    while ((c = fgetc(f)) == ' ' || c == '\t' || c == '\r' || c == '\n');
+    while (c == '#') {
+        while ((c = fgetc(f)) != '\n' && c != EOF);
+        while ((c = fgetc(f)) == ' ' || c == '\t' || c == '\r' || c == '\n');
+    }
+    ungetc(c, f);
+
+    int w, h, maxval;
+    if (fscanf(f, "%d %d %d", &w, &h, &maxval) != 3) {
+        fprintf(stderr, "Bad PGM header: %s\n", path);
+        fclose(f); return NULL;
+    }
+    fgetc(f); /* consume trailing whitespace */
+
+    if (maxval != 255) {
+        fprintf(stderr, "Unsupported bit depth (maxval=%d): %s\n", maxval, path);
+        fclose(f); return NULL;
+    }
+
+    unsigned char *buf = malloc((size_t)w * h);
+    if (!buf) { perror("malloc"); fclose(f); return NULL; }
+
+    if (fread(buf, 1, (size_t)w * h, f) != (size_t)w * h) {
+        fprintf(stderr, "Short read: %s\n", path);
+        free(buf); fclose(f); return NULL;
+    }
+
+    fclose(f);
+    *out_w = w;
+    *out_h = h;
+    return buf;
+}
+
+/* ------------------------------------------------------------------ */
+/* Shared state                                                        */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    const char    *path;
+    unsigned char *pix;
+    int            w, h;
+    SigfmImgInfo  *golden;      /* read-only after the golden run */
+    int            golden_kp;
+    int           *golden_score;    /* [pairs]: vs frame (i + 1 + k) % n */
+} Frame;
+
+typedef struct {
+    Frame *frames;
+    int    n_frames;
+    int    pairs;
+    int    rounds;
+    int    id;
+    int    n_threads;
+    /* results */
+    long   extracts;
+    long   matches;
+    long   mismatches;
+} Worker;
+
+static double
+now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+/* ------------------------------------------------------------------ */
+/* Worker                                                              */
+/* ------------------------------------------------------------------ */
+
+static void *
+worker_run(void *arg)
+{
+    Worker *wk = arg;
+    const int n = wk->n_frames;
+    SigfmImgInfo **mine = calloc((size_t)n, sizeof(*mine));
+    if (!mine) { wk->mismatches = -1; return NULL; }
+
+    for (int r = 0; r < wk->rounds; r++) {
+        /* Stagger start so threads contend on the same frames */
+        int start = (int)(((long)wk->id * n) / wk->n_threads + r) % n;
+
+        for (int s = 0; s < n; s++) {
+            int i = (start + s) % n;
+            Frame *f = &wk->frames[i];
+
+            mine[i] = sigfm_extract(f->pix, f->w, f->h);
+            wk->extracts++;
+            int kp = mine[i] ? sigfm_keypoints_count(mine[i]) : -1;
+            if (kp != f->golden_kp) {
+                fprintf(stderr, "  [t%d] %s: keypoints %d, golden %d\n",
+                        wk->id, f->path, kp, f->golden_kp);
+                wk->mismatches++;
+            }
+        }
+
+        for (int s = 0; s < n; s++) {
+            int i = (start + s) % n;
+            if (!mine[i]) continue;
+            for (int k = 0; k < wk->pairs; k++) {
+                int j = (i + 1 + k) % n;
+                int want = wk->frames[i].golden_score[k];
+
+                int got_private = mine[j] ? sigfm_match_score(mine[i], mine[j]) : -1;
+                int got_shared = wk->frames[j].golden
+                               ? sigfm_match_score(mine[i], wk->frames[j].golden) : -1;
+                wk->matches += 2;
+                if (got_private != want || got_shared != want) {
+                    fprintf(stderr, "  [t%d] %s vs %s: score %d/%d, golden %d\n",
+                            wk->id, wk->frames[i].path, wk->frames[j].path,
+                            got_private, got_shared, want);
+                    wk->mismatches++;
+                }
+            }
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (mine[i]) sigfm_free_info(mine[i]);
+            mine[i] = NULL;
+        }
+    }
+
+    free(mine);
+    return NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/* Usage                                                               */
+/* ------------------------------------------------------------------ */
+
+static void
+usage(const char *argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [--threads=N] [--rounds=N] [--pairs=K] f1.pgm f2.pgm ...\n"
+        "\n"
+        "  --threads=N   concurrent workers (default: %d, max %d)\n"
+        "  --rounds=N    passes over all frames per worker (default: %d)\n"
+        "  --pairs=K     each frame is matched against the next K (default: %d)\n"
+        "\n"
+        "Compares every extraction and match against a single-threaded golden\n"
+        "run; exits 1 on any difference.\n",
+        argv0, DEFAULT_THREADS, MAX_THREADS, DEFAULT_ROUNDS, DEFAULT_PAIRS);
+    exit(1);
+}
+
+/* ------------------------------------------------------------------ */
+/* Main                                                                */
+/* ------------------------------------------------------------------ */
+
+int
+main(int argc, char *argv[])
+{
+    static Frame frames[MAX_FRAMES];
+    int n_frames = 0;
+    int threads = DEFAULT_THREADS;
+    int rounds = DEFAULT_ROUNDS;
+    int pairs = DEFAULT_PAIRS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--threads=", 10) == 0)
+            threads = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "--rounds=", 9) == 0)
+            rounds = atoi(argv[i] + 9);
+        else if (strncmp(argv[i], "--pairs=", 8) == 0)
+            pairs = atoi(argv[i] + 8);
+        else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+            usage(argv[0]);
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            usage(argv[0]);
+        } else if (n_frames < MAX_FRAMES) {
+            Frame *f = &frames[n_frames];
+            f->path = argv[i];
+            f->pix = read_pgm(argv[i], &f->w, &f->h);
+            if (f->pix)
+                n_frames++;
+        }
+    }
+    if (threads < 1 || threads > MAX_THREADS || rounds < 1 || pairs < 0)
+        usage(argv[0]);
+    if (n_frames < 2) {
+        fprintf(stderr, "Need at least 2 readable frames\n");
+        usage(argv[0]);
+    }
+    if (pairs > n_frames - 1)
+        pairs = n_frames - 1;
+
+    /* ── Golden run (single thread) ────────────────────────────── */
+
+    double t0 = now_ms();
+    for (int i = 0; i < n_frames; i++) {
+        Frame *f = &frames[i];
+        f->golden = sigfm_extract(f->pix, f->w, f->h);
+        f->golden_kp = f->golden ? sigfm_keypoints_count(f->golden) : -1;
+        f->golden_score = malloc((size_t)(pairs > 0 ? pairs : 1) * sizeof(int));
+        if (!f->golden_score) { perror("malloc"); return 1; }
+    }
+    for (int i = 0; i < n_frames; i++)
+        for (int k = 0; k < pairs; k++) {
+            int j = (i + 1 + k) % n_frames;
+            frames[i].golden_score[k] = (frames[i].golden && frames[j].golden)
+                ? sigfm_match_score(frames[i].golden, frames[j].golden) : -1;
+        }
+    double golden_ms = now_ms() - t0;
+
+    printf("Golden run: %d frames, %d matches in %.1f ms\n",
+           n_frames, n_frames * pairs, golden_ms);
+
+    /* ── Concurrent runs ───────────────────────────────────────── */
+
+    Worker workers[MAX_THREADS];
+    pthread_t tids[MAX_THREADS];
+
+    t0 = now_ms();
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (Worker){
+            .frames = frames, .n_frames = n_frames, .pairs = pairs,
+            .rounds = rounds, .id = t, .n_threads = threads,
+        };
+        if (pthread_create(&tids[t], NULL, worker_run, &workers[t]) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+
+    long extracts = 0, matches = 0, mismatches = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tids[t], NULL);
+        if (workers[t].mismatches < 0) {
+            fprintf(stderr, "Worker %d failed to allocate\n", t);
+            return 1;
+        }
+        extracts += workers[t].extracts;
+        matches += workers[t].matches;
+        mismatches += workers[t].mismatches;
+    }
+    double stress_ms = now_ms() - t0;
+
+    printf("Stress run: %d threads × %d rounds: %ld extractions, %ld matches in %.1f ms\n",
+           threads, rounds, extracts, matches, stress_ms);
+    printf("Result:     %s (%ld mismatches vs golden)\n",
+           mismatches ? "FAIL" : "OK", mismatches);
+
+    for (int i = 0; i < n_frames; i++) {
+        if (frames[i].golden) sigfm_free_info(frames[i].golden);
+        free(frames[i].golden_score);
+        free(frames[i].pix);
+    }
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,293 @@
+/*
+ * trace-bench.c — Cost of per-stage scan tracing (P25, doc 20 §26)
+ *
+ * Measures what goodix-trace adds to a scan: one span per stage with a
+ * monotonic clock read, as the SSM records it, and the formatting of the
+ * one debug line per operation.  Also checks the ring: wrap-around keeps
+ * the newest spans in order and counts the rest as dropped, and a short
+ * buffer truncates without changing the reported length.  A failed check
+ * makes the tool exit 1.
+ *
+ * --log=N prints N operations of synthetic `goodix trace: stages` lines,
+ * GLib-prefixed like G_MESSAGES_DEBUG=all output, for exercising
+ * scripts/stage-latency.py without a sensor.  The stage durations are
+ * made up (lognormal around fixed medians, with cached calibration on
+ * most touches and an occasional retry); they are not measurements.
+ *
+ * Usage:
+ *   trace-bench [--ops=N] [--log=N] [--seed=S]
+ *
+ * Build:  see Makefile
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "goodix-trace.h"
+
+/* ================================================================== */
+/* Defaults                                                            */
+/* ================================================================== */
+
+#define DEFAULT_OPS         200000
+#define DEFAULT_SEED        1
+#define LINE_MAX_BYTES      1024
+
+static int64_t
+now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static double
+now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void
+usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [--ops=N] [--log=N] [--seed=S]\n", prog);
+    exit(1);
+}
+
+/* ================================================================== */
+/* Synthetic stage durations                                           */
+/* ================================================================== */
+
+static uint64_t rng_state;
+
+static double
+rng_uniform(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (double)(rng_state >> 11) / 9007199254740992.0;
+}
+
+/* Lognormal around median_us, sigma in log space */
+static int64_t
+rng_stage(double median_us, double sigma)
+{
+    double u1 = rng_uniform() + 1e-12, u2 = rng_uniform();
+    double z = sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+    return (int64_t)(median_us * exp(sigma * z));
+}
+
+static const struct {
+    GoodixStage stage;
+    double      median_us;
+    double      sigma;
+} synth[] = {
+    { GOODIX_STAGE_FDT_ACK,      400, 0.3 },
+    { GOODIX_STAGE_CALIBRATION,  300, 0.2 },   /* cached; captured below */
+    { GOODIX_STAGE_XFER,       10000, 0.1 },
+    { GOODIX_STAGE_DECRYPT,      250, 0.2 },
+    { GOODIX_STAGE_PREPROCESS,   900, 0.2 },
+    { GOODIX_STAGE_STDDEV_GATE,   20, 0.3 },
+    { GOODIX_STAGE_EXTRACT,     6000, 0.3 },
+    { GOODIX_STAGE_MATCH,      12000, 0.4 },
+};
+
+/* One synthetic operation; returns the end time */
+static int64_t
+synth_op(GoodixTrace *t, const char *op, int64_t touch_us)
+{
+    int64_t now = touch_us;
+    int attempts = rng_uniform() < 0.1 ? 2 : 1;
+
+    goodix_trace_begin(t, op, touch_us);
+    for (int a = 0; a < attempts; a++) {
+        for (size_t i = 0; i < sizeof(synth) / sizeof(synth[0]); i++) {
+            if (a > 0 && synth[i].stage <= GOODIX_STAGE_CALIBRATION)
+                continue;
+            double med = synth[i].median_us;
+            if (synth[i].stage == GOODIX_STAGE_CALIBRATION && rng_uniform() < 0.2)
+                med = 25000;                    /* captured, not cached */
+            now += rng_stage(med, synth[i].sigma);
+            goodix_trace_mark(t, synth[i].stage, now);
+        }
+    }
+    now += rng_stage(150, 0.3);
+    goodix_trace_mark(t, GOODIX_STAGE_RESULT, now);
+    return now;
+}
+
+static int
+emit_log(int ops)
+{
+    static const char *ops_names[] = { "verify", "verify", "verify", "identify" };
+    GoodixTrace t;
+    char line[LINE_MAX_BYTES];
+    int64_t clock_us = (int64_t)(9 * 3600 + 30 * 60) * 1000000;
+
+    for (int i = 0; i < ops; i++) {
+        const char *op = ops_names[(unsigned)(rng_uniform() * 4) & 3];
+        clock_us += 2000000 + rng_stage(1000000, 0.5);
+        clock_us = synth_op(&t, op, clock_us);
+        goodix_trace_format(&t, line, sizeof(line));
+
+        int64_t ms = clock_us / 1000;
+        printf("(fprintd:4242): libfprint-goodixtls-DEBUG: "
+               "%02" PRId64 ":%02" PRId64 ":%02" PRId64 ".%03" PRId64
+               ": goodix trace: %s\n",
+               ms / 3600000 % 24, ms / 60000 % 60, ms / 1000 % 60, ms % 1000, line);
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* Checks                                                              */
+/* ================================================================== */
+
+static int
+check_ring(void)
+{
+    GoodixTrace t;
+    char full[4096], shortbuf[40];
+    int fails = 0;
+
+    /* 40 spans into a 32-entry ring: the last 32 survive, in order */
+    goodix_trace_begin(&t, "verify", 1000);
+    for (int i = 0; i < 40; i++)
+        goodix_trace_span(&t, (GoodixStage)(i % GOODIX_STAGE_COUNT),
+                          1000 + i * 10, 1000 + i * 10 + i);
+    size_t need = goodix_trace_format(&t, full, sizeof(full));
+    if (need != strlen(full)) {
+        printf("FAIL  format length %zu, wrote %zu\n", need, strlen(full));
+        fails++;
+    }
+    if (!strstr(full, " n=40 dropped=8 total=429 ")) {
+        printf("FAIL  header: %s\n", full);
+        fails++;
+    }
+    /* first kept span is i=8: stage 8 % 9 = result, start 80, dur 8 */
+    if (!strstr(full, "total=429 result=80+8 fdt=90+9 ")) {
+        printf("FAIL  oldest kept span: %s\n", full);
+        fails++;
+    }
+    /* last span is i=39: stage 3 = decrypt, start 390, dur 39 */
+    size_t fl = strlen(full);
+    if (fl < 15 || strcmp(full + fl - 15, " decrypt=390+39")) {
+        printf("FAIL  newest span: %s\n", full);
+        fails++;
+    }
+
+    size_t need_short = goodix_trace_format(&t, shortbuf, sizeof(shortbuf));
+    if (need_short != need || strlen(shortbuf) != sizeof(shortbuf) - 1 ||
+        strncmp(shortbuf, full, sizeof(shortbuf) - 1)) {
+        printf("FAIL  truncated format: need %zu/%zu, \"%s\"\n",
+               need_short, need, shortbuf);
+        fails++;
+    }
+
+    /* A worker span that overlaps the main loop keeps its own start */
+    goodix_trace_begin(&t, "verify", 0);
+    goodix_trace_mark(&t, GOODIX_STAGE_XFER, 10000);
+    goodix_trace_mark(&t, GOODIX_STAGE_XFER, 20000);
+    goodix_trace_span(&t, GOODIX_STAGE_EXTRACT, 10500, 16500);
+    goodix_trace_mark(&t, GOODIX_STAGE_RESULT, 20200);
+    goodix_trace_format(&t, full, sizeof(full));
+    if (!strstr(full, "total=20200 xfer=0+10000 xfer=10000+10000 "
+                      "extract=10500+6000 result=20000+200")) {
+        printf("FAIL  overlapping span: %s\n", full);
+        fails++;
+    }
+
+    if (!fails)
+        printf("Ring checks: wrap, truncation, overlapping spans OK\n");
+    return fails;
+}
+
+/* ================================================================== */
+/* Cost                                                                */
+/* ================================================================== */
+
+static volatile size_t sink;
+
+static void
+bench(int ops)
+{
+    GoodixTrace t;
+    char line[LINE_MAX_BYTES];
+    double t0, clock_ns, mark_ns, fmt_ns;
+    int64_t acc = 0;
+
+    /* The clock read alone, which every mark in the driver pays */
+    t0 = now_ns();
+    for (int i = 0; i < ops * 9; i++)
+        acc += now_us();
+    clock_ns = (now_ns() - t0) / ((double)ops * 9);
+
+    /* Nine marks per operation, each with its own clock read */
+    t0 = now_ns();
+    for (int i = 0; i < ops; i++) {
+        goodix_trace_begin(&t, "verify", now_us());
+        for (int s = 0; s < GOODIX_STAGE_COUNT; s++)
+            goodix_trace_mark(&t, (GoodixStage)s, now_us());
+        acc += t.last_us;
+    }
+    mark_ns = (now_ns() - t0) / ((double)ops * GOODIX_STAGE_COUNT);
+
+    /* Formatting the line once per operation */
+    size_t len = 0;
+    int fmt_ops = ops / 10 ? ops / 10 : 1;
+    t0 = now_ns();
+    for (int i = 0; i < fmt_ops; i++)
+        len += goodix_trace_format(&t, line, sizeof(line));
+    fmt_ns = (now_ns() - t0) / fmt_ops;
+    sink = len + (size_t)acc;
+
+    printf("\nPer-stage trace cost (%d operations, %d stages each)\n",
+           ops, GOODIX_STAGE_COUNT);
+    printf("  %-28s %10s\n", "", "ns");
+    printf("  %-28s %10.1f\n", "clock read", clock_ns);
+    printf("  %-28s %10.1f\n", "mark (clock read + store)", mark_ns);
+    printf("  %-28s %10.1f\n", "format line", fmt_ns);
+    printf("  %-28s %10.1f\n", "per operation",
+           mark_ns * GOODIX_STAGE_COUNT + fmt_ns);
+    printf("  line: %zu bytes, trace state: %zu bytes\n",
+           strlen(line), sizeof(GoodixTrace));
+}
+
+int
+main(int argc, char **argv)
+{
+    int ops = DEFAULT_OPS;
+    int log_ops = 0;
+    uint64_t seed = DEFAULT_SEED;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--ops=", 6) == 0)
+            ops = atoi(argv[i] + 6);
+        else if (strncmp(argv[i], "--log=", 6) == 0)
+            log_ops = atoi(argv[i] + 6);
+        else if (strncmp(argv[i], "--seed=", 7) == 0)
+            seed = strtoull(argv[i] + 7, NULL, 10);
+        else
+            usage(argv[0]);
+    }
+    if (ops < 1 || log_ops < 0)
+        usage(argv[0]);
+    rng_state = seed ? seed : DEFAULT_SEED;
+
+    if (log_ops)
+        return emit_log(log_ops);
+
+    int fails = check_ring();
+    bench(ops);
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,342 @@
+/*
+ * transport-bench.c — GnuTLS in-memory transport buffers (P13, doc 20 §14)
+ *
+ * Pushes image-sized TLS records through the transport the way the driver
+ * does — the USB receive path appends each received chunk, GnuTLS's pull
+ * callback then consumes the record from the front — and compares:
+ *
+ *   gbytearray  g_byte_array_append() + g_byte_array_remove_range(…, 0, n),
+ *               modelled on GLib (power-of-two growth, memmove of the
+ *               remaining bytes on every consume) — the current driver
+ *   ring        goodix_ring_push() / goodix_ring_pull(), no memmove
+ *   ring-span   the USB transfer lands directly in goodix_ring_write_span(),
+ *               saving the staging copy as well; when the span at the tail
+ *               is shorter than the transfer (the ring wraps), the transfer
+ *               goes to the staging buffer and goodix_ring_push() instead,
+ *               as a bulk transfer needs one contiguous buffer.  The share
+ *               of transfers taking that fallback is reported.
+ *
+ * Pull patterns: "gnutls" reads the 5-byte record header and then the
+ * body in one call (what gnutls_record_recv() asks for when the whole
+ * record is buffered); a number N reads N bytes per call, which is what a
+ * small-read consumer such as goodix_tls_client_read() or a short pull
+ * request costs.  Every variant's output is checked against the pushed
+ * stream before timing.
+ *
+ * Usage:
+ *   transport-bench [--record=N] [--records=N] [--backlog=K]
+ *                   [--chunks=C1,C2,...] [--pulls=gnutls,N,...]
+ *
+ * Build:  see Makefile
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "goodix-ring.h"
+
+/* ================================================================== */
+/* Defaults                                                            */
+/* ================================================================== */
+
+#define DEFAULT_RECORD      14080   /* one 88×80 uint16 frame */
+#define DEFAULT_RECORDS     2000
+#define DEFAULT_BACKLOG     1       /* records buffered before GnuTLS reads */
+#define TLS_HEADER          5
+#define PULL_GNUTLS         0
+#define MAX_LIST            16
+#define RING_INITIAL        (32 * 1024)
+
+static double
+now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/* ================================================================== */
+/* GByteArray model                                                    */
+/* ================================================================== */
+
+typedef struct {
+    uint8_t *data;
+    size_t   len, alloc;
+    uint64_t moved;         /* bytes memmoved by remove_range */
+} ByteArray;
+
+/* g_array_maybe_expand(): grow to the nearest power of two */
+static int
+ba_append(ByteArray *ba, const uint8_t *src, size_t n)
+{
+    if (ba->len + n > ba->alloc) {
+        size_t want = 16;
+        while (want < ba->len + n)
+            want <<= 1;
+        uint8_t *data = realloc(ba->data, want);
+        if (!data) return -1;
+        ba->data = data;
+        ba->alloc = want;
+    }
+    memcpy(ba->data + ba->len, src, n);
+    ba->len += n;
+    return 0;
+}
+
+/* memcpy out, then g_byte_array_remove_range(ba, 0, n) */
+static size_t
+ba_pull(ByteArray *ba, uint8_t *dst, size_t n)
+{
+    if (n > ba->len) n = ba->len;
+    memcpy(dst, ba->data, n);
+    memmove(ba->data, ba->data + n, ba->len - n);
+    ba->moved += ba->len - n;
+    ba->len -= n;
+    return n;
+}
+
+/* ================================================================== */
+/* Transport variants                                                  */
+/* ================================================================== */
+
+enum { V_GBYTEARRAY, V_RING, V_RING_SPAN, N_VARIANTS };
+static const char *variant_name[N_VARIANTS] = { "gbytearray", "ring", "ring-span" };
+
+typedef struct {
+    int        variant;
+    ByteArray  ba;
+    GoodixRing ring;
+    uint8_t   *usb_buf;     /* staging buffer the USB transfer fills */
+    uint64_t   transfers;
+    uint64_t   fallbacks;   /* ring-span: span too short, staged + pushed */
+} Transport;
+
+/* One USB transfer of `n` bytes arriving from `src` */
+static int
+transport_receive(Transport *t, const uint8_t *src, size_t n)
+{
+    t->transfers++;
+    switch (t->variant) {
+    case V_GBYTEARRAY:
+        memcpy(t->usb_buf, src, n);
+        return ba_append(&t->ba, t->usb_buf, n);
+    case V_RING:
+        memcpy(t->usb_buf, src, n);
+        return goodix_ring_push(&t->ring, t->usb_buf, n);
+    default: {
+        if (goodix_ring_reserve(&t->ring, n) != 0) return -1;
+        uint8_t *span;
+        if (goodix_ring_write_span(&t->ring, &span) >= n) {
+            memcpy(span, src, n);           /* the transfer writes here */
+            goodix_ring_commit(&t->ring, n);
+            return 0;
+        }
+        /* Free space wraps: one transfer cannot straddle it */
+        t->fallbacks++;
+        memcpy(t->usb_buf, src, n);
+        return goodix_ring_push(&t->ring, t->usb_buf, n);
+    }
+    }
+}
+
+static size_t
+transport_pull(Transport *t, uint8_t *dst, size_t n)
+{
+    if (t->variant == V_GBYTEARRAY)
+        return ba_pull(&t->ba, dst, n);
+    return goodix_ring_pull(&t->ring, dst, n);
+}
+
+/* ================================================================== */
+/* Run                                                                 */
+/* ================================================================== */
+
+typedef struct {
+    double   us_per_record;
+    double   moved_per_record;
+    double   fallback_pct;      /* ring-span transfers that were staged */
+    int      ok;
+} RunResult;
+
+/* Pushes `records` records of `record` bytes in `chunk`-byte transfers,
+ * keeping `backlog` records buffered, and pulls them with `pull`.  With
+ * `check`, compares every pulled byte with the source. */
+static void
+run(int variant, const uint8_t *src, size_t record, int records, int backlog,
+    size_t chunk, size_t pull, int check, RunResult *res)
+{
+    Transport t = { .variant = variant };
+    uint8_t *out = malloc(record);
+    t.usb_buf = malloc(chunk);
+    if (!out || !t.usb_buf || goodix_ring_init(&t.ring, RING_INITIAL) != 0) {
+        perror("malloc");
+        exit(1);
+    }
+
+    res->ok = 1;
+    int pushed = 0;
+    double t0 = now_us();
+    for (int rec = 0; rec < records; rec++) {
+        while (pushed < records && pushed < rec + backlog) {
+            for (size_t off = 0; off < record; off += chunk) {
+                size_t n = record - off < chunk ? record - off : chunk;
+                if (transport_receive(&t, src + off, n) != 0) {
+                    perror("transport");
+                    exit(1);
+                }
+            }
+            pushed++;
+        }
+
+        size_t got = 0;
+        while (got < record) {
+            size_t want = pull == PULL_GNUTLS
+                        ? (got == 0 ? TLS_HEADER : record - got)
+                        : (record - got < pull ? record - got : pull);
+            size_t n = transport_pull(&t, out + got, want);
+            if (n == 0) break;
+            got += n;
+        }
+        if (check && (got != record || memcmp(out, src, record) != 0))
+            res->ok = 0;
+    }
+    double us = now_us() - t0;
+
+    res->us_per_record = us / records;
+    res->moved_per_record = (double)t.ba.moved / records;
+    res->fallback_pct = t.transfers ? 100.0 * (double)t.fallbacks / (double)t.transfers : 0;
+
+    free(t.ba.data);
+    goodix_ring_free(&t.ring);
+    free(t.usb_buf);
+    free(out);
+}
+
+/* ================================================================== */
+/* Usage                                                               */
+/* ================================================================== */
+
+static void
+usage(const char *argv0)
+{
+    fprintf(stderr,
+        "Usage: %s [--record=N] [--records=N] [--backlog=K]\n"
+        "          [--chunks=C1,C2,...] [--pulls=gnutls,N,...]\n"
+        "\n"
+        "  --record=N     TLS record size in bytes (default: %d)\n"
+        "  --records=N    records per measurement (default: %d)\n"
+        "  --backlog=K    records buffered ahead of the reader (default: %d)\n"
+        "  --chunks=...   USB transfer sizes; 0 = whole record (default: 64,512,0)\n"
+        "  --pulls=...    pull sizes; gnutls = header + body (default: gnutls,512,64)\n",
+        argv0, DEFAULT_RECORD, DEFAULT_RECORDS, DEFAULT_BACKLOG);
+    exit(1);
+}
+
+static int
+parse_list(const char *s, size_t *out)
+{
+    int n = 0;
+    while (*s && n < MAX_LIST) {
+        if (strncmp(s, "gnutls", 6) == 0) {
+            out[n++] = PULL_GNUTLS;
+            s += 6;
+        } else {
+            char *end;
+            long v = strtol(s, &end, 10);
+            if (end == s || v < 0) return -1;
+            out[n++] = (size_t)v;
+            s = end;
+        }
+        if (*s == ',') s++;
+        else if (*s) return -1;
+    }
+    return n;
+}
+
+/* ================================================================== */
+/* Main                                                                */
+/* ================================================================== */
+
+int
+main(int argc, char *argv[])
+{
+    size_t record = DEFAULT_RECORD;
+    int records = DEFAULT_RECORDS;
+    int backlog = DEFAULT_BACKLOG;
+    size_t chunks[MAX_LIST] = { 64, 512, 0 };
+    size_t pulls[MAX_LIST] = { PULL_GNUTLS, 512, 64 };
+    int n_chunks = 3, n_pulls = 3;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--record=", 9) == 0)
+            record = (size_t)atol(argv[i] + 9);
+        else if (strncmp(argv[i], "--records=", 10) == 0)
+            records = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "--backlog=", 10) == 0)
+            backlog = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "--chunks=", 9) == 0)
+            n_chunks = parse_list(argv[i] + 9, chunks);
+        else if (strncmp(argv[i], "--pulls=", 8) == 0)
+            n_pulls = parse_list(argv[i] + 8, pulls);
+        else
+            usage(argv[0]);
+    }
+    if (record <= TLS_HEADER || records < 1 || backlog < 1 || n_chunks < 1 || n_pulls < 1)
+        usage(argv[0]);
+
+    uint8_t *src = malloc(record);
+    if (!src) { perror("malloc"); return 1; }
+    uint32_t rng = 0x1234567u;
+    for (size_t i = 0; i < record; i++) {
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        src[i] = (uint8_t)rng;
+    }
+
+    printf("transport-bench: %zu-byte records × %d, backlog %d\n\n", record, records, backlog);
+    printf("  %-7s  %-7s  %14s  %14s  %14s  %16s  %14s\n", "chunk", "pull",
+           variant_name[0], variant_name[1], variant_name[2], "memmove/record",
+           "span fallback");
+
+    int failures = 0;
+    for (int c = 0; c < n_chunks; c++) {
+        size_t chunk = chunks[c] ? chunks[c] : record;
+        for (int p = 0; p < n_pulls; p++) {
+            RunResult res[N_VARIANTS];
+            for (int v = 0; v < N_VARIANTS; v++) {
+                RunResult check;
+                run(v, src, record, backlog + 2, backlog, chunk, pulls[p], 1, &check);
+                if (!check.ok) {
+                    fprintf(stderr, "  MISMATCH: %s chunk %zu pull %zu\n",
+                            variant_name[v], chunk, pulls[p]);
+                    failures++;
+                }
+                run(v, src, record, records, backlog, chunk, pulls[p], 0, &res[v]);
+            }
+
+            char chunk_s[24], pull_s[24];
+            snprintf(chunk_s, sizeof(chunk_s), "%zu", chunk);
+            if (pulls[p] == PULL_GNUTLS)
+                snprintf(pull_s, sizeof(pull_s), "gnutls");
+            else
+                snprintf(pull_s, sizeof(pull_s), "%zu", pulls[p]);
+            printf("  %-7s  %-7s  %11.2f us  %11.2f us  %11.2f us  %13.0f KB  %13.1f%%\n",
+                   chunk_s, pull_s,
+                   res[V_GBYTEARRAY].us_per_record, res[V_RING].us_per_record,
+                   res[V_RING_SPAN].us_per_record,
+                   res[V_GBYTEARRAY].moved_per_record / 1024.0,
+                   res[V_RING_SPAN].fallback_pct);
+        }
+    }
+
+    free(src);
+    if (failures) {
+        printf("\n  %d variant(s) returned wrong bytes\n", failures);
+        return 1;
+    }
+    return 0;
+}
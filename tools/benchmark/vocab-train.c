@@ -0,0 +1,714 @@
+/*
+ * vocab-train.c — Offline BRIEF-256 vocabulary tree trainer + identify benchmark
+ *
+ * Trains a DBoW-style hierarchical vocabulary (k-majority clustering in
+ * Hamming space, k branches × L levels) over BRIEF-256 descriptors and writes
+ * it to a file the driver can load for multi-user identify (P2, doc 20 §3).
+ *
+ * In --bench mode it builds a gallery of users × fingers × sub-templates,
+ * indexes every sub-template in an inverted file (visual word → tf-idf
+ * weighted postings), and compares identify latency of:
+ *
+ *   linear     brute-force KNN + ratio test against every sub-template
+ *   vocab      tf-idf shortlist of S sub-templates, then the same KNN
+ *              verification on the shortlist only
+ *
+ * Usage:
+ *   vocab-train -o vocab.bin desc_0001.bin desc_0002.bin ...
+ *   vocab-train -o vocab.bin --synthetic=40
+ *   vocab-train --bench [--vocab=vocab.bin] [--users=1,5,10,25,50]
+ *               [--fingers=N] [--shortlist=N] [--probes=N]
+ *
+ * Descriptor dumps are desc_NNNN.bin files written next to raw_NNNN.bin by
+ * the driver's FP_SAVE_RAW path (32-byte records, keypoint order).
+ *
+ * Build:  see Makefile
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "brief-desc.h"
+
+/* ================================================================== */
+/* Parameters                                                          */
+/* ================================================================== */
+
+#define DEFAULT_K           8       /* branching factor */
+#define DEFAULT_LEVELS      4       /* 8^4 = 4096 words */
+#define KMAJ_ITERS          8       /* k-majority refinement passes */
+#define DEFAULT_SHORTLIST   50      /* sub-templates verified after tf-idf */
+#define DEFAULT_FINGERS     2       /* enrolled fingers per user */
+#define SUBTEMPLATES        20      /* goodix511.c nr_enroll_stages */
+#define DEFAULT_PROBES      50
+#define RATIO_TEST          0.80f   /* sigfm.c RATIO_TEST */
+#define MAX_USER_STEPS      16
+
+#define VOCAB_MAGIC         0x54565847u  /* "GXVT" little endian */
+
+/* ================================================================== */
+/* Vocabulary tree                                                     */
+/* ================================================================== */
+
+/* Complete k-ary tree stored breadth-first: children of node i are
+ * i*k+1 … i*k+k.  Leaves (the visual words) are the last k^L nodes. */
+typedef struct {
+    int        k;
+    int        levels;
+    int        n_nodes;
+    int        n_words;
+    int        first_leaf;
+    BriefDesc *centers;     /* n_nodes (root unused) */
+    float     *idf;         /* n_words */
+} VocabTree;
+
+static int
+ipow(int b, int e)
+{
+    int r = 1;
+    while (e-- > 0) r *= b;
+    return r;
+}
+
+static int
+vocab_alloc(VocabTree *v, int k, int levels)
+{
+    v->k = k;
+    v->levels = levels;
+    v->n_words = ipow(k, levels);
+    v->n_nodes = (ipow(k, levels + 1) - 1) / (k - 1);
+    v->first_leaf = v->n_nodes - v->n_words;
+    v->centers = calloc((size_t)v->n_nodes, sizeof(BriefDesc));
+    v->idf = calloc((size_t)v->n_words, sizeof(float));
+    if (!v->centers || !v->idf) {
+        perror("calloc");
+        return -1;
+    }
+    return 0;
+}
+
+static void
+vocab_free(VocabTree *v)
+{
+    free(v->centers);
+    free(v->idf);
+    memset(v, 0, sizeof(*v));
+}
+
+/* Per-bit majority of the descriptors assigned to each cluster, one pass
+ * over pts.  Clusters that lost all members keep their previous center. */
+static void
+majority_centers(const BriefDesc *const *pts, const int *assign, int n, int k,
+                 BriefDesc *centers)
+{
+    int (*counts)[BRIEF_BYTES * 8] = calloc((size_t)k, sizeof(*counts));
+    int *members = calloc((size_t)k, sizeof(int));
+    if (!counts || !members) { perror("calloc"); exit(1); }
+
+    for (int i = 0; i < n; i++) {
+        int c = assign[i];
+        members[c]++;
+        for (int w = 0; w < BRIEF_WORDS; w++) {
+            uint64_t bits = pts[i]->w[w];
+            while (bits) {
+                counts[c][w * 64 + __builtin_ctzll(bits)]++;
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    for (int c = 0; c < k; c++) {
+        if (members[c] == 0) continue;
+        memset(&centers[c], 0, sizeof(BriefDesc));
+        for (int bit = 0; bit < BRIEF_BYTES * 8; bit++)
+            if (counts[c][bit] * 2 > members[c])
+                centers[c].w[bit >> 6] |= 1ULL << (bit & 63);
+    }
+
+    free(members);
+    free(counts);
+}
+
+/* k-majority clustering of pts into v->centers[first..first+k), then
+ * recurse into each cluster until the leaf level. */
+static void
+train_node(VocabTree *v, int node, int level, const BriefDesc **pts, int n,
+           uint64_t *rng)
+{
+    if (level >= v->levels) return;
+
+    int k = v->k;
+    int first = node * k + 1;
+    BriefDesc *c = &v->centers[first];
+
+    if (n == 0) {
+        /* Empty subtree: inherit the parent center so descent is defined */
+        for (int j = 0; j < k; j++)
+            c[j] = v->centers[node];
+        for (int j = 0; j < k; j++)
+            train_node(v, first + j, level + 1, pts, 0, rng);
+        return;
+    }
+
+    /* k-means++ seeding with squared Hamming distance */
+    int *assign = malloc((size_t)n * sizeof(int));
+    int *dmin = malloc((size_t)n * sizeof(int));
+    if (!assign || !dmin) { perror("malloc"); exit(1); }
+
+    c[0] = *pts[brief_rng_next(rng) % (uint64_t)n];
+    for (int i = 0; i < n; i++)
+        dmin[i] = brief_hamming(pts[i], &c[0]);
+    for (int j = 1; j < k; j++) {
+        double total = 0;
+        for (int i = 0; i < n; i++)
+            total += (double)dmin[i] * dmin[i];
+        int pick = 0;
+        if (total > 0) {
+            double r = brief_rng_unit(rng) * total;
+            for (pick = 0; pick < n - 1; pick++) {
+                r -= (double)dmin[pick] * dmin[pick];
+                if (r <= 0) break;
+            }
+        }
+        c[j] = *pts[pick];
+        for (int i = 0; i < n; i++) {
+            int d = brief_hamming(pts[i], &c[j]);
+            if (d < dmin[i]) dmin[i] = d;
+        }
+    }
+
+    for (int it = 0; it < KMAJ_ITERS; it++) {
+        int changed = 0;
+        for (int i = 0; i < n; i++) {
+            int best = 0, bd = brief_hamming(pts[i], &c[0]);
+            for (int j = 1; j < k; j++) {
+                int d = brief_hamming(pts[i], &c[j]);
+                if (d < bd) { bd = d; best = j; }
+            }
+            if (it == 0 || assign[i] != best) changed++;
+            assign[i] = best;
+        }
+        if (it > 0 && changed == 0) break;
+        majority_centers(pts, assign, n, k, c);
+    }
+
+    /* Partition pts by cluster and recurse */
+    const BriefDesc **sub = malloc((size_t)n * sizeof(*sub));
+    if (!sub) { perror("malloc"); exit(1); }
+    for (int j = 0; j < k; j++) {
+        int m = 0;
+        for (int i = 0; i < n; i++)
+            if (assign[i] == j) sub[m++] = pts[i];
+        train_node(v, first + j, level + 1, sub, m, rng);
+    }
+
+    free(sub);
+    free(dmin);
+    free(assign);
+}
+
+/* Descend from the root to a leaf: L × k Hamming distances */
+static int
+vocab_word(const VocabTree *v, const BriefDesc *d)
+{
+    int node = 0;
+    for (int level = 0; level < v->levels; level++) {
+        int first = node * v->k + 1;
+        int best = first, bd = brief_hamming(d, &v->centers[first]);
+        for (int j = 1; j < v->k; j++) {
+            int dd = brief_hamming(d, &v->centers[first + j]);
+            if (dd < bd) { bd = dd; best = first + j; }
+        }
+        node = best;
+    }
+    return node - v->first_leaf;
+}
+
+/* idf = log(N / n_w) over the training frames; unseen words get log(N) */
+static void
+vocab_compute_idf(VocabTree *v, const BriefSet *frames, int n_frames)
+{
+    int *df = calloc((size_t)v->n_words, sizeof(int));
+    int *seen = malloc((size_t)v->n_words * sizeof(int));
+    if (!df || !seen) { perror("calloc"); exit(1); }
+    for (int w = 0; w < v->n_words; w++) seen[w] = -1;
+
+    for (int f = 0; f < n_frames; f++) {
+        for (int i = 0; i < frames[f].n; i++) {
+            int w = vocab_word(v, &frames[f].d[i]);
+            if (seen[w] != f) { seen[w] = f; df[w]++; }
+        }
+    }
+    for (int w = 0; w < v->n_words; w++)
+        v->idf[w] = (float)log((double)n_frames / (df[w] > 0 ? df[w] : 1));
+
+    free(seen);
+    free(df);
+}
+
+static int
+vocab_train(VocabTree *v, const BriefSet *frames, int n_frames, int k, int levels,
+            uint64_t seed)
+{
+    if (vocab_alloc(v, k, levels) < 0) return -1;
+
+    int total = 0;
+    for (int f = 0; f < n_frames; f++) total += frames[f].n;
+    const BriefDesc **pts = malloc((size_t)total * sizeof(*pts));
+    if (!pts) { perror("malloc"); return -1; }
+    int m = 0;
+    for (int f = 0; f < n_frames; f++)
+        for (int i = 0; i < frames[f].n; i++)
+            pts[m++] = &frames[f].d[i];
+
+    uint64_t rng = seed ? seed : 1;
+    train_node(v, 0, 0, pts, total, &rng);
+    free(pts);
+
+    vocab_compute_idf(v, frames, n_frames);
+    return 0;
+}
+
+/* File layout (little endian): magic, k, levels, centers[n_nodes], idf[n_words] */
+static int
+vocab_save(const VocabTree *v, const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) { perror(path); return -1; }
+    uint32_t hdr[3] = { VOCAB_MAGIC, (uint32_t)v->k, (uint32_t)v->levels };
+    int ok = fwrite(hdr, sizeof(hdr), 1, f) == 1 &&
+             fwrite(v->centers, sizeof(BriefDesc), (size_t)v->n_nodes, f) == (size_t)v->n_nodes &&
+             fwrite(v->idf, sizeof(float), (size_t)v->n_words, f) == (size_t)v->n_words;
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+static int
+vocab_load(VocabTree *v, const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return -1; }
+    uint32_t hdr[3];
+    if (fread(hdr, sizeof(hdr), 1, f) != 1 || hdr[0] != VOCAB_MAGIC ||
+        hdr[1] < 2 || hdr[1] > 16 || hdr[2] < 1 || hdr[2] > 8) {
+        fprintf(stderr, "%s: not a vocabulary file\n", path);
+        fclose(f);
+        return -1;
+    }
+    if (vocab_alloc(v, (int)hdr[1], (int)hdr[2]) < 0) { fclose(f); return -1; }
+    int ok = fread(v->centers, sizeof(BriefDesc), (size_t)v->n_nodes, f) == (size_t)v->n_nodes &&
+             fread(v->idf, sizeof(float), (size_t)v->n_words, f) == (size_t)v->n_words;
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "%s: truncated vocabulary\n", path);
+        vocab_free(v);
+        return -1;
+    }
+    return 0;
+}
+
+/* ================================================================== */
+/* Bag-of-words vectors + inverted file                                */
+/* ================================================================== */
+
+typedef struct {
+    int   word[BRIEF_MAX_KP];
+    float weight[BRIEF_MAX_KP];
+    int   n;
+} BowVec;
+
+/* tf-idf, L1 normalised (DBoW2 L1 scoring) */
+static void
+bow_transform(const VocabTree *v, const BriefSet *s, BowVec *out)
+{
+    out->n = 0;
+    for (int i = 0; i < s->n; i++) {
+        int w = vocab_word(v, &s->d[i]);
+        int j;
+        for (j = 0; j < out->n; j++)
+            if (out->word[j] == w) break;
+        if (j == out->n) {
+            out->word[j] = w;
+            out->weight[j] = 0;
+            out->n++;
+        }
+        out->weight[j] += v->idf[w];
+    }
+    float sum = 0;
+    for (int j = 0; j < out->n; j++) sum += out->weight[j];
+    if (sum > 0)
+        for (int j = 0; j < out->n; j++) out->weight[j] /= sum;
+}
+
+typedef struct {
+    int   doc;
+    float weight;
+} Posting;
+
+typedef struct {
+    Posting **list;     /* per word */
+    int      *len;
+    int      *cap;
+    int       n_words;
+    int       n_docs;
+} InvFile;
+
+static void
+inv_init(InvFile *inv, int n_words)
+{
+    inv->n_words = n_words;
+    inv->n_docs = 0;
+    inv->list = calloc((size_t)n_words, sizeof(*inv->list));
+    inv->len = calloc((size_t)n_words, sizeof(int));
+    inv->cap = calloc((size_t)n_words, sizeof(int));
+    if (!inv->list || !inv->len || !inv->cap) { perror("calloc"); exit(1); }
+}
+
+static void
+inv_free(InvFile *inv)
+{
+    for (int w = 0; w < inv->n_words; w++) free(inv->list[w]);
+    free(inv->list);
+    free(inv->len);
+    free(inv->cap);
+}
+
+static void
+inv_add(InvFile *inv, const BowVec *bv)
+{
+    int doc = inv->n_docs++;
+    for (int j = 0; j < bv->n; j++) {
+        int w = bv->word[j];
+        if (inv->len[w] == inv->cap[w]) {
+            inv->cap[w] = inv->cap[w] ? inv->cap[w] * 2 : 8;
+            inv->list[w] = realloc(inv->list[w], (size_t)inv->cap[w] * sizeof(Posting));
+            if (!inv->list[w]) { perror("realloc"); exit(1); }
+        }
+        inv->list[w][inv->len[w]++] = (Posting){ doc, bv->weight[j] };
+    }
+}
+
+/* L1 score s = 1 − ½‖a − b‖₁, accumulated over shared words only:
+ * for L1-normalised vectors ½·Σ(|a|+|b|−|a−b|) over common words. */
+static void
+inv_score(const InvFile *inv, const BowVec *q, float *score)
+{
+    memset(score, 0, (size_t)inv->n_docs * sizeof(float));
+    for (int j = 0; j < q->n; j++) {
+        int w = q->word[j];
+        float qa = q->weight[j];
+        for (int p = 0; p < inv->len[w]; p++) {
+            float da = inv->list[w][p].weight;
+            score[inv->list[w][p].doc] += qa + da - fabsf(qa - da);
+        }
+    }
+}
+
+/* ================================================================== */
+/* Verification stand-in: brute-force 2-NN + ratio test                */
+/* ================================================================== */
+
+/* The KNN stage of sigfm_match_score() — 128×128 Hamming distances plus
+ * the ratio test.  RANSAC is not reproduced, so linear-scan latency here
+ * is a lower bound; a shortlist saves the RANSAC cost as well. */
+static int
+knn_ratio_matches(const BriefSet *a, const BriefSet *b)
+{
+    int matches = 0;
+    for (int i = 0; i < a->n; i++) {
+        int d1 = 1 << 30, d2 = 1 << 30;
+        for (int j = 0; j < b->n; j++) {
+            int d = brief_hamming(&a->d[i], &b->d[j]);
+            if (d < d1) { d2 = d1; d1 = d; }
+            else if (d < d2) d2 = d;
+        }
+        if ((float)d1 < RATIO_TEST * (float)d2) matches++;
+    }
+    return matches;
+}
+
+/* ================================================================== */
+/* Benchmark                                                           */
+/* ================================================================== */
+
+static int
+parse_int_list(const char *s, int *out, int max)
+{
+    int n = 0;
+    while (*s && n < max) {
+        out[n++] = atoi(s);
+        const char *comma = strchr(s, ',');
+        if (!comma) break;
+        s = comma + 1;
+    }
+    return n;
+}
+
+static int
+run_bench(const VocabTree *v, const int *users, int n_steps, int fingers,
+          int shortlist, int n_probes)
+{
+    int max_users = 0;
+    for (int i = 0; i < n_steps; i++)
+        if (users[i] > max_users) max_users = users[i];
+
+    int n_prints = max_users * fingers;
+    int n_docs = n_prints * SUBTEMPLATES;
+
+    /* Gallery fingers use seeds disjoint from the training set */
+    SynthFinger *fing = malloc((size_t)n_prints * sizeof(SynthFinger));
+    BriefSet *docs = malloc((size_t)n_docs * sizeof(BriefSet));
+    BowVec *bows = malloc((size_t)n_docs * sizeof(BowVec));
+    float *score = malloc((size_t)n_docs * sizeof(float));
+    if (!fing || !docs || !bows || !score) { perror("malloc"); return 1; }
+
+    uint64_t rng = 0xC0FFEEULL;
+    for (int p = 0; p < n_prints; p++) {
+        synth_finger_init(&fing[p], 1000003ULL + (uint64_t)p);
+        for (int s = 0; s < SUBTEMPLATES; s++) {
+            synth_capture(&fing[p], &docs[p * SUBTEMPLATES + s], &rng);
+            bow_transform(v, &docs[p * SUBTEMPLATES + s], &bows[p * SUBTEMPLATES + s]);
+        }
+    }
+
+    printf("\nIdentify benchmark: %d finger(s)/user × %d sub-templates, "
+           "shortlist=%d, %d probes/step\n", fingers, SUBTEMPLATES, shortlist, n_probes);
+    printf("  Users | Prints | Sub-tmpl | Linear µs | Vocab µs | Speed-up | "
+           "Recall | Agree\n");
+    printf("  ------|--------|----------|-----------|----------|----------|"
+           "--------|------\n");
+
+    for (int step = 0; step < n_steps; step++) {
+        int prints = users[step] * fingers;
+        int nd = prints * SUBTEMPLATES;
+
+        InvFile inv;
+        inv_init(&inv, v->n_words);
+        for (int d = 0; d < nd; d++) inv_add(&inv, &bows[d]);
+
+        double t_lin = 0, t_voc = 0;
+        int recall = 0, agree = 0;
+        uint64_t prng = 0xBADC0DEULL + (uint64_t)step;
+
+        for (int q = 0; q < n_probes; q++) {
+            int truth = (int)(brief_rng_next(&prng) % (uint64_t)prints);
+            BriefSet probe;
+            synth_capture(&fing[truth], &probe, &prng);
+
+            /* Linear: every sub-template of every print */
+            double t0 = brief_now_us();
+            int lin_best = -1, lin_score = -1;
+            for (int d = 0; d < nd; d++) {
+                int m = knn_ratio_matches(&probe, &docs[d]);
+                if (m > lin_score) { lin_score = m; lin_best = d / SUBTEMPLATES; }
+            }
+            t_lin += brief_now_us() - t0;
+
+            /* Vocabulary: transform, score, verify top-S only */
+            t0 = brief_now_us();
+            BowVec qb;
+            bow_transform(v, &probe, &qb);
+            inv_score(&inv, &qb, score);
+
+            int top[256];
+            int s_len = shortlist < nd ? shortlist : nd;
+            if (s_len > 256) s_len = 256;
+            int filled = 0;
+            for (int d = 0; d < nd; d++) {
+                if (filled < s_len) {
+                    int j = filled++;
+                    while (j > 0 && score[top[j - 1]] < score[d]) { top[j] = top[j - 1]; j--; }
+                    top[j] = d;
+                } else if (score[d] > score[top[s_len - 1]]) {
+                    int j = s_len - 1;
+                    while (j > 0 && score[top[j - 1]] < score[d]) { top[j] = top[j - 1]; j--; }
+                    top[j] = d;
+                }
+            }
+            int voc_best = -1, voc_score = -1;
+            for (int i = 0; i < s_len; i++) {
+                int m = knn_ratio_matches(&probe, &docs[top[i]]);
+                if (m > voc_score) { voc_score = m; voc_best = top[i] / SUBTEMPLATES; }
+            }
+            t_voc += brief_now_us() - t0;
+
+            for (int i = 0; i < s_len; i++)
+                if (top[i] / SUBTEMPLATES == truth) { recall++; break; }
+            if (voc_best == lin_best) agree++;
+        }
+
+        printf("  %5d | %6d | %8d | %9.0f | %8.0f | %7.1f× | %5.1f%% | %4.1f%%\n",
+               users[step], prints, nd, t_lin / n_probes, t_voc / n_probes,
+               t_voc > 0 ? t_lin / t_voc : 0.0,
+               100.0 * recall / n_probes, 100.0 * agree / n_probes);
+        inv_free(&inv);
+    }
+
+    printf("\n  Recall: probe's true print has ≥1 sub-template in the shortlist.\n"
+           "  Agree:  shortlist verification picks the same print as linear scan.\n");
+
+    free(score);
+    free(bows);
+    free(docs);
+    free(fing);
+    return 0;
+}
+
+/* ================================================================== */
+/* Usage                                                               */
+/* ================================================================== */
+
+static void
+usage(const char *argv0)
+{
+    fprintf(stderr,
+        "Usage: %s -o vocab.bin [--k=N] [--levels=N] desc_0001.bin ...\n"
+        "       %s -o vocab.bin --synthetic=N   train on N synthetic fingers\n"
+        "       %s --bench [--vocab=FILE] [--users=1,5,10,25,50] [--fingers=N]\n"
+        "                  [--shortlist=N] [--probes=N]\n"
+        "\n"
+        "  --k=N          branching factor (default: %d)\n"
+        "  --levels=N     tree depth, words = k^levels (default: %d)\n"
+        "  --seed=N       clustering seed (default: 1)\n"
+        "  --fingers=N    enrolled fingers per user in --bench (default: %d)\n"
+        "  --shortlist=N  sub-templates verified after tf-idf (default: %d)\n"
+        "  --probes=N     identify queries per gallery size (default: %d)\n"
+        "\n"
+        "--bench without --vocab trains on 40 synthetic fingers disjoint from\n"
+        "the gallery.\n",
+        argv0, argv0, argv0, DEFAULT_K, DEFAULT_LEVELS, DEFAULT_FINGERS,
+        DEFAULT_SHORTLIST, DEFAULT_PROBES);
+    exit(1);
+}
+
+/* ================================================================== */
+/* Main                                                                */
+/* ================================================================== */
+
+int
+main(int argc, char *argv[])
+{
+    const char *out_path = NULL;
+    const char *vocab_path = NULL;
+    const char *files[4096];
+    int n_files = 0;
+    int k = DEFAULT_K, levels = DEFAULT_LEVELS;
+    int synthetic = 0;
+    int do_bench = 0;
+    int fingers = DEFAULT_FINGERS;
+    int shortlist = DEFAULT_SHORTLIST;
+    int probes = DEFAULT_PROBES;
+    int users[MAX_USER_STEPS] = { 1, 5, 10, 25, 50 };
+    int n_steps = 5;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            out_path = argv[++i];
+        else if (strncmp(argv[i], "--vocab=", 8) == 0)
+            vocab_path = argv[i] + 8;
+        else if (strncmp(argv[i], "--k=", 4) == 0)
+            k = atoi(argv[i] + 4);
+        else if (strncmp(argv[i], "--levels=", 9) == 0)
+            levels = atoi(argv[i] + 9);
+        else if (strncmp(argv[i], "--seed=", 7) == 0)
+            seed = strtoull(argv[i] + 7, NULL, 10);
+        else if (strncmp(argv[i], "--synthetic=", 12) == 0)
+            synthetic = atoi(argv[i] + 12);
+        else if (strcmp(argv[i], "--bench") == 0)
+            do_bench = 1;
+        else if (strncmp(argv[i], "--users=", 8) == 0)
+            n_steps = parse_int_list(argv[i] + 8, users, MAX_USER_STEPS);
+        else if (strncmp(argv[i], "--fingers=", 10) == 0)
+            fingers = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "--shortlist=", 12) == 0)
+            shortlist = atoi(argv[i] + 12);
+        else if (strncmp(argv[i], "--probes=", 9) == 0)
+            probes = atoi(argv[i] + 9);
+        else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+            usage(argv[0]);
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            usage(argv[0]);
+        } else if (n_files < 4096)
+            files[n_files++] = argv[i];
+    }
+
+    if (k < 2 || k > 16 || levels < 1 || levels > 8 || ipow(k, levels) > (1 << 20)) {
+        fprintf(stderr, "Unsupported tree shape k=%d levels=%d\n", k, levels);
+        return 1;
+    }
+    if (fingers < 1 || probes < 1 || shortlist < 1 || n_steps < 1)
+        usage(argv[0]);
+
+    if (!do_bench && !out_path)
+        usage(argv[0]);
+    if (do_bench && !vocab_path && !synthetic)
+        synthetic = 40;
+
+    VocabTree vocab = { 0 };
+
+    if (vocab_path) {
+        if (vocab_load(&vocab, vocab_path) < 0) return 1;
+        printf("Loaded vocabulary %s: k=%d levels=%d (%d words)\n",
+               vocab_path, vocab.k, vocab.levels, vocab.n_words);
+    } else {
+        int n_frames = synthetic ? synthetic * SUBTEMPLATES : n_files;
+        if (n_frames == 0) {
+            fprintf(stderr, "No training descriptors (give desc_*.bin or --synthetic=N)\n");
+            return 1;
+        }
+        BriefSet *frames = malloc((size_t)n_frames * sizeof(BriefSet));
+        if (!frames) { perror("malloc"); return 1; }
+
+        int loaded = 0;
+        if (synthetic) {
+            uint64_t rng = 0x5EED5EEDULL;
+            for (int fgr = 0; fgr < synthetic; fgr++) {
+                SynthFinger sf;
+                synth_finger_init(&sf, (uint64_t)fgr + 1);
+                for (int s = 0; s < SUBTEMPLATES; s++)
+                    synth_capture(&sf, &frames[loaded++], &rng);
+            }
+        } else {
+            for (int i = 0; i < n_files; i++)
+                if (brief_set_read(files[i], &frames[loaded]) > 0)
+                    loaded++;
+        }
+
+        long total = 0;
+        for (int f = 0; f < loaded; f++) total += frames[f].n;
+        printf("Training k=%d levels=%d (%d words) on %d frames, %ld descriptors%s...\n",
+               k, levels, ipow(k, levels), loaded, total, synthetic ? " (synthetic)" : "");
+
+        double t0 = brief_now_us();
+        if (vocab_train(&vocab, frames, loaded, k, levels, seed) < 0) {
+            free(frames);
+            return 1;
+        }
+        printf("  Trained in %.1f ms\n", (brief_now_us() - t0) / 1000.0);
+        free(frames);
+
+        if (out_path) {
+            if (vocab_save(&vocab, out_path) < 0) {
+                fprintf(stderr, "Failed to write %s\n", out_path);
+                vocab_free(&vocab);
+                return 1;
+            }
+            printf("  Wrote %s (%zu bytes)\n", out_path,
+                   12 + (size_t)vocab.n_nodes * sizeof(BriefDesc) +
+                   (size_t)vocab.n_words * sizeof(float));
+        }
+    }
+
+    int ret = 0;
+    if (do_bench)
+        ret = run_bench(&vocab, users, n_steps, fingers, shortlist, probes);
+
+    vocab_free(&vocab);
+    return ret;
+}
@@ -49,6 +49,18 @@ def image_stats(arr):
     return stats
 
 
+def _parse_kv(args, keys, defaults=None):
+    """Integer values of `keys` from a trace marker's key=value arguments,
+    as a tuple in `keys` order.  A key missing from `args` takes its value
+    from `defaults`; None if one is still missing or is not an integer."""
+    kv = dict(defaults or {})
+    kv.update(a.split('=', 1) for a in args if '=' in a)
+    try:
+        return tuple(int(kv[k]) for k in keys)
+    except (KeyError, ValueError):
+        return None
+
+
 def parse_libfprint_log(log_path):
     """Extract SIGFM metrics from libfprint debug log (G_MESSAGES_DEBUG=all)."""
     metrics = {}
@@ -73,6 +85,165 @@ def parse_libfprint_log(log_path):
     if scores:
         metrics['match_scores'] = [(int(s), int(t)) for s, t in scores]
 
+    # Driver trace markers.  GLib prefixes debug lines with HH:MM:SS.mmm:
+    #   libfprint-goodixtls-DEBUG: 12:34:56.789: goodix trace: finger-up
+    trace = []
+    for m in re.finditer(r'(\d\d):(\d\d):(\d\d)\.(\d{3}): goodix trace: '
+                         r'([\w-]+)([^\n]*)', text):
+        hh, mm, ss, ms, event, args = m.groups()
+        t = ((int(hh) * 60 + int(mm)) * 60 + int(ss)) * 1000 + int(ms)
+        trace.append((t, event, args.split()))
+
+    def elapsed(t0, t1):
+        return (t1 - t0) % (24 * 3600 * 1000)  # midnight wrap
+
+    # Finger-up → result latency (P8, doc 20 §9): finger-up … result
+    latencies = []
+    t_up = None
+    for t, event, _ in trace:
+        if event == 'finger-up':
+            t_up = t
+        elif event == 'result' and t_up is not None:
+            latencies.append(elapsed(t_up, t))
+            t_up = None
+    if latencies:
+        metrics['finger_up_to_result_ms'] = latencies
+
+    # Per-press latency by calibration source (P10, doc 20 §11):
+    #   finger-down … calibration cached|captured [drift=N] … image
+    by_cal = {'cached': [], 'captured': []}
+    drifts = []
+    t_down, cal = None, None
+    for t, event, args in trace:
+        if event == 'finger-down':
+            t_down, cal = t, None
+        elif event == 'calibration' and args:
+            cal = args[0]
+            drift = _parse_kv(args[1:], ('drift',))
+            if drift:
+                drifts.append(drift[0])
+        elif event == 'image' and t_down is not None:
+            if cal in by_cal:
+                by_cal[cal].append(elapsed(t_down, t))
+            t_down = None
+    if by_cal['cached'] or by_cal['captured']:
+        metrics['down_to_image_ms'] = by_cal
+    if drifts:
+        metrics['calibration_drift'] = drifts
+
+    # Image-path copies per scan (P14, doc 20 §15):
+    #   image copied=<bytes> allocs=<n>
+    copies = []
+    for _, event, args in trace:
+        if event == 'image':
+            vals = _parse_kv(args, ('copied', 'allocs'))
+            if vals:
+                copies.append(vals)
+    if copies:
+        metrics['image_copies'] = copies
+
+    # In-driver match retries (P16, doc 20 §17):
+    #   retry n=<k> added=<ms since the first attempt's result>
+    retries = []
+    for _, event, args in trace:
+        if event == 'retry':
+            vals = _parse_kv(args, ('n', 'added'))
+            if vals:
+                retries.append(vals)
+    if retries:
+        metrics['match_retries'] = retries
+
+    # Most-recently-matched visit order (P17, doc 20 §18):
+    #   mru pos=<accepting MRU position, -1 on reject> visited=<n> of=<count>
+    mru = []
+    for _, event, args in trace:
+        if event == 'mru':
+            vals = _parse_kv(args, ('pos', 'visited', 'of'))
+            if vals:
+                mru.append(vals)
+    if mru:
+        metrics['mru_order'] = mru
+
+    # Burst capture (P22, doc 20 §23), one per touch, frames=1 without burst:
+    #   burst frames=<captured> passed=<past the gates> pick=<1-based, 0 = none> match=<0|1>
+    bursts = []
+    for _, event, args in trace:
+        if event == 'burst':
+            vals = _parse_kv(args, ('frames', 'passed', 'pick', 'match'))
+            if vals:
+                bursts.append(vals)
+    if bursts:
+        metrics['burst_touches'] = bursts
+
+    # Touch → result (P23, doc 20 §24), measured by the driver from the
+    # finger-down that started the touch, so it spans a whole burst:
+    #   result touch_ms=<ms> frames=<captured before the result>
+    touch = []
+    for _, event, args in trace:
+        if event == 'result':
+            vals = _parse_kv(args, ('touch_ms', 'frames'), {'frames': 1})
+            if vals:
+                touch.append(vals)
+    if touch:
+        metrics['touch_to_result_ms'] = touch
+
+    # Decoded-gallery cache (P19, doc 20 §20):
+    #   gallery prints=<n> hits=<h> decode_us=<spent> saved_us=<hits' decode time>
+    gallery = []
+    for _, event, args in trace:
+        if event == 'gallery':
+            vals = _parse_kv(args, ('prints', 'hits', 'decode_us', 'saved_us'))
+            if vals:
+                gallery.append(vals)
+    if gallery:
+        metrics['gallery_cache'] = gallery
+
+    # Claim → ready-for-finger by activation path (P11, doc 20 §12):
+    #   open … activate full|fast … ready
+    by_path = {'full': [], 'fast': []}
+    t_open, path = None, None
+    for t, event, args in trace:
+        if event == 'open':
+            t_open, path = t, None
+        elif event == 'activate' and args:
+            path = args[0]
+        elif event == 'ready' and t_open is not None:
+            if path in by_path:
+                by_path[path].append(elapsed(t_open, t))
+            t_open = None
+    if by_path['full'] or by_path['fast']:
+        metrics['open_to_ready_ms'] = by_path
+
+    # TLS session use per activation (P12, doc 20 §13):
+    #   tls handshake | tls reuse | tls rehandshake reason=<why>
+    tls = {'handshake': 0, 'reuse': 0, 'rehandshake': 0}
+    reasons = {}
+    for _, event, args in trace:
+        if event == 'tls' and args and args[0] in tls:
+            tls[args[0]] += 1
+            for a in args[1:]:
+                if a.startswith('reason='):
+                    reasons[a[7:]] = reasons.get(a[7:], 0) + 1
+    if any(tls.values()):
+        metrics['tls_sessions'] = (tls, reasons)
+
+    # Per-state SSM timing from libfprint's own fpi-ssm debug lines:
+    #   12:34:56.789: [goodixtls511] ACTIVATE_NUM_STATES entering state 3
+    # A state lasts until the next transition of the same machine.
+    ssm = {}
+    current = {}
+    for m in re.finditer(r'(\d\d):(\d\d):(\d\d)\.(\d{3}): \[[^\]]+\] (\w+) '
+                         r'(entering state (\d+)|completed|failed)', text):
+        hh, mm, ss, ms, name, what, state = m.groups()
+        t = ((int(hh) * 60 + int(mm)) * 60 + int(ss)) * 1000 + int(ms)
+        if name in current:
+            prev_state, t0 = current.pop(name)
+            ssm.setdefault(name, {}).setdefault(prev_state, []).append(elapsed(t0, t))
+        if state is not None:
+            current[name] = (int(state), t)
+    if ssm:
+        metrics['ssm_state_ms'] = ssm
+
     # Not enough keypoints found / SIGFM extraction failed
     if 'Not enough keypoints' in text:
         metrics['rejected'] = 'not enough keypoints (<25)'
@@ -94,7 +265,7 @@ def print_report(pgm_path, stats, log_metrics=None):
     print(f"  Coverage:    {stats['coverage_pct']:.0f}%  (Windows rejects <65%)")
 
     if log_metrics:
-        print(f"\n  ── libfprint SIGFM metrics (from debug log) ──")
+        print(f"\n  ── libfprint metrics (from debug log) ──")
         if 'keypoints' in log_metrics:
             kp = log_metrics['keypoints']
             status = '✓' if kp >= 25 else f'✗ (<25, rejected)'
@@ -105,8 +276,86 @@ def print_report(pgm_path, stats, log_metrics=None):
             for score, threshold in log_metrics['match_scores']:
                 result = '✓ match' if score >= threshold else '✗ no match'
                 print(f"  Score:       {score}/{threshold}  {result}")
+        if 'finger_up_to_result_ms' in log_metrics:
+            lat = sorted(log_metrics['finger_up_to_result_ms'])
+            print(f"  Up→result:   median {lat[len(lat) // 2]} ms  "
+                  f"(min {lat[0]}, max {lat[-1]}, n={len(lat)})")
+        if 'down_to_image_ms' in log_metrics:
+            for cal, lat in log_metrics['down_to_image_ms'].items():
+                if not lat:
+                    continue
+                lat = sorted(lat)
+                print(f"  Down→image:  median {lat[len(lat) // 2]} ms  "
+                      f"(min {lat[0]}, max {lat[-1]}, n={len(lat)}), "
+                      f"calibration {cal}")
+        if 'open_to_ready_ms' in log_metrics:
+            for path, lat in log_metrics['open_to_ready_ms'].items():
+                if not lat:
+                    continue
+                lat = sorted(lat)
+                print(f"  Open→ready:  median {lat[len(lat) // 2]} ms  "
+                      f"(min {lat[0]}, max {lat[-1]}, n={len(lat)}), "
+                      f"{path} activation")
+        if 'tls_sessions' in log_metrics:
+            tls, reasons = log_metrics['tls_sessions']
+            why = ', '.join(f'{r} {n}' for r, n in sorted(reasons.items()))
+            print(f"  TLS:         {tls['handshake']} handshakes, {tls['reuse']} "
+                  f"reused, {tls['rehandshake']} re-handshakes"
+                  + (f" ({why})" if why else ""))
+        if 'match_retries' in log_metrics:
+            r = log_metrics['match_retries']
+            added = sorted(a for _, a in r)
+            print(f"  Retries:     {len(r)} (up to #{max(n for n, _ in r)}), added "
+                  f"median {added[len(added) // 2]} ms, max {added[-1]} ms")
+        if 'mru_order' in log_metrics:
+            m = log_metrics['mru_order']
+            acc = [p for p, _, _ in m if p >= 0]
+            if acc:
+                hit = sum(1 for p in acc if p == 0)
+                top2 = sum(1 for p in acc if p <= 1)
+                print(f"  MRU order:   hit {100 * hit / len(acc):.0f}%, top-2 "
+                      f"{100 * top2 / len(acc):.0f}% of {len(acc)} accepts, "
+                      f"{sum(v for _, v, _ in m) / len(m):.1f} of "
+                      f"{max(n for _, _, n in m)} visited per verify")
+        if 'burst_touches' in log_metrics:
+            b = log_metrics['burst_touches']
+            ok = sum(x[3] for x in b)
+            gated = sum(1 for x in b if x[2] == 0)
+            per = f"{len(b) / ok:.2f}" if ok else "∞"
+            print(f"  Burst:       {per} touches per match ({ok} of {len(b)}, "
+                  f"{gated} fully gated), {sum(x[0] for x in b) / len(b):.1f} frames "
+                  f"and {sum(x[1] for x in b) / len(b):.1f} passed per touch")
+        if 'touch_to_result_ms' in log_metrics:
+            t = log_metrics['touch_to_result_ms']
+            lat = sorted(ms for ms, _ in t)
+            print(f"  Touch→result: median {lat[len(lat) // 2]} ms  "
+                  f"(min {lat[0]}, max {lat[-1]}, n={len(lat)}), "
+                  f"{sum(f for _, f in t) / len(t):.1f} frames per touch")
+        if 'gallery_cache' in log_metrics:
+            g = log_metrics['gallery_cache']
+            prints = sum(x[0] for x in g)
+            hits = sum(x[1] for x in g)
+            print(f"  Gallery:     {hits}/{prints} prints from cache "
+                  f"({100 * hits / max(prints, 1):.0f}%), decode "
+                  f"{sum(x[2] for x in g) / len(g):.0f} us spent, "
+                  f"{sum(x[3] for x in g) / len(g):.0f} us saved per operation")
+        if 'image_copies' in log_metrics:
+            c = sorted(log_metrics['image_copies'])
+            print(f"  Image path:  median {c[len(c) // 2][0]} B copied, "
+                  f"{c[len(c) // 2][1]} allocs per scan  (max {c[-1][0]} B, n={len(c)})")
+        if 'calibration_drift' in log_metrics:
+            d = sorted(log_metrics['calibration_drift'])
+            print(f"  Cal drift:   median {d[len(d) // 2]}  (max {d[-1]}, "
+                  f"n={len(d)} cached presses)")
         if 'rejected' in log_metrics:
             print(f"  Rejected:    {log_metrics['rejected']}")
+        for name, states in log_metrics.get('ssm_state_ms', {}).items():
+            total = sum(sum(v) / len(v) for v in states.values())
+            print(f"  SSM {name}: {total:.0f} ms mean total")
+            for state in sorted(states):
+                v = states[state]
+                print(f"    state {state:2d}:  mean {sum(v) / len(v):6.1f} ms  "
+                      f"(max {max(v)}, n={len(v)})")
 
     # Verdict
     print()
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""
+stage-latency.py — Per-stage latency percentiles from driver trace logs
+
+Aggregates the one-line-per-operation stage trace (P25, doc 20 §26) over
+any number of libfprint debug logs:
+
+    ... goodix trace: stages op=verify n=9 dropped=0 total=40197 fdt=0+557 cal=557+260 ...
+
+Each <stage>=<start>+<duration> entry is µs relative to the touch; the
+start is negative for a stage that began before it.  A stage that runs
+more than once in an operation (retry, burst) is summed per operation,
+so each row is "time this stage cost a touch"; `runs` is the mean number
+of times it ran.  `share` is the stage's summed time over the summed
+touch→result totals; worker stages overlap the main loop, so shares need
+not add up to 100%.
+
+Usage:
+    python3 stage-latency.py capture1.log [capture2.log ...] [--op verify] [--csv]
+
+    tools/benchmark/trace-bench --log=500 > /tmp/synthetic.log   # no sensor needed
+"""
+
+import sys
+import argparse
+import math
+import re
+import signal
+
+STAGES = ['fdt', 'cal', 'xfer', 'decrypt', 'preprocess', 'gate',
+          'extract', 'match', 'result']
+
+LINE = re.compile(r'goodix trace: stages (.*)$')
+SPAN = re.compile(r'^(\w+)=(-?\d+)\+(\d+)$')
+HEADER = ('op', 'n', 'dropped', 'total')
+
+
+def parse_logs(paths):
+    """Return ({op: [(total_us, dropped, {stage: (runs, sum_us)})]}, unparsed)
+    where unparsed counts tokens that were neither a span nor a header."""
+    ops = {}
+    unparsed = 0
+    for path in paths:
+        try:
+            with open(path, errors='replace') as f:
+                lines = f.readlines()
+        except OSError as e:
+            print(f"{path}: {e}", file=sys.stderr)
+            continue
+        for line in lines:
+            m = LINE.search(line.rstrip('\n'))
+            if not m:
+                continue
+            head, stages = {}, {}
+            for tok in m.group(1).split():
+                s = SPAN.match(tok)
+                if s:
+                    name, dur = s.group(1), int(s.group(3))
+                    runs, total = stages.get(name, (0, 0))
+                    stages[name] = (runs + 1, total + dur)
+                elif tok.split('=', 1)[0] in HEADER and '=' in tok:
+                    k, v = tok.split('=', 1)
+                    head[k] = v
+                else:
+                    unparsed += 1
+            if 'op' not in head or 'total' not in head:
+                continue
+            ops.setdefault(head['op'], []).append(
+                (int(head['total']), int(head.get('dropped', 0)), stages))
+    return ops, unparsed
+
+
+def percentile(sorted_vals, p):
+    """Nearest-rank percentile of an already sorted list."""
+    if not sorted_vals:
+        return 0
+    k = max(0, min(len(sorted_vals) - 1, math.ceil(p / 100 * len(sorted_vals)) - 1))
+    return sorted_vals[k]
+
+
+def summarize(records):
+    """Rows of (stage, n, runs, p50, p90, p99, max, share) in µs."""
+    totals = sorted(r[0] for r in records)
+    grand = sum(totals) or 1
+    names = [s for s in STAGES if any(s in r[2] for r in records)]
+    names += sorted({s for r in records for s in r[2]} - set(STAGES))
+    rows = []
+    for name in names:
+        per_op = sorted(r[2][name][1] for r in records if name in r[2])
+        runs = sum(r[2][name][0] for r in records if name in r[2])
+        rows.append((name, len(per_op), runs / len(per_op),
+                     percentile(per_op, 50), percentile(per_op, 90),
+                     percentile(per_op, 99), per_op[-1], sum(per_op) / grand))
+    rows.append(('total', len(totals), 1.0,
+                 percentile(totals, 50), percentile(totals, 90),
+                 percentile(totals, 99), totals[-1], 1.0))
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Per-stage scan latency percentiles')
+    parser.add_argument('logs', nargs='+', help='libfprint debug logs (G_MESSAGES_DEBUG=all)')
+    parser.add_argument('--op', help='only this operation (verify, identify, enroll)')
+    parser.add_argument('--csv', action='store_true', help='CSV instead of tables')
+    args = parser.parse_args()
+
+    # Piped into head/less: exit quietly when the reader goes away
+    signal.signal(signal.SIGPIPE, signal.SIG_DFL)
+
+    ops, unparsed = parse_logs(args.logs)
+    if unparsed:
+        print(f"warning: {unparsed} trace token(s) not understood and skipped",
+              file=sys.stderr)
+    if args.op:
+        ops = {k: v for k, v in ops.items() if k == args.op}
+    if not ops:
+        print("No 'goodix trace: stages' lines found")
+        return 1
+
+    if args.csv:
+        print('op,stage,n,runs,p50_us,p90_us,p99_us,max_us,share')
+        for op in sorted(ops):
+            for r in summarize(ops[op]):
+                print(f'{op},{r[0]},{r[1]},{r[2]:.2f},{r[3]},{r[4]},{r[5]},{r[6]},{r[7]:.3f}')
+        return 0
+
+    for op in sorted(ops):
+        records = ops[op]
+        dropped = sum(1 for r in records if r[1])
+        print(f"\n=== {op}: {len(records)} operations from {len(args.logs)} log(s) ===")
+        if dropped:
+            print(f"  {dropped} operation(s) overflowed the trace ring; oldest spans missing")
+        print(f"  {'stage':<12} {'n':>6} {'runs':>5} {'p50 ms':>8} {'p90 ms':>8} "
+              f"{'p99 ms':>8} {'max ms':>8} {'share':>6}")
+        for name, n, runs, p50, p90, p99, mx, share in summarize(records):
+            if name == 'total':
+                print(f"  {'-' * 66}")
+            print(f"  {name:<12} {n:>6} {runs:>5.2f} {p50 / 1000:>8.2f} {p90 / 1000:>8.2f} "
+                  f"{p99 / 1000:>8.2f} {mx / 1000:>8.2f} {share * 100:>5.1f}%")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())